@@ -20,11 +20,52 @@ An info node about the Verb Alternatives found and possibly executed
 #include "params.h"
 #include "literal.h"
 #include "syntax.h"
+#include "syserr.h"
 
 
 /* Types */
 typedef AltInfo *AltInfoFinder(int verb, Parameter parameters[]);
 
+/* The alternatives for a verb in an instance and its classes, or in
+   the classes of a literal, or globally, found in order, for a
+   parameter number. They don't change during the game, only which
+   instances the command is about and where it is given. */
+typedef struct AlternativeChain {
+    int verb;
+    Aint parameterNumber;
+    Aid holder;                 /* Instance, or class for literals */
+    bool literal;
+    bool meta;                  /* Any of them found in a meta verb */
+    int count;
+    AltEntry **alts;
+    Aid *classes;               /* Where found, NO_CLASS if in the instance */
+    struct AlternativeChain *next;
+} AlternativeChain;
+
+
+/* Private data */
+#define CHAIN_BUCKETS 1024
+static AlternativeChain *chains[CHAIN_BUCKETS];
+
+/* The array returned from findAllAlternatives() is reused */
+static AltInfo *altInfoBuffer = NULL;
+static int altInfoBufferSize = 0;
+
+/* Results of checks which don't depend on the parameters or the
+   current instance, remembered while the parser tries candidates, as
+   nothing else changes then. Checks which do depend on them are also
+   remembered so that it is not recorded what they read again. */
+typedef struct RememberedCheck {
+    AltEntry *alt;
+    bool dependent;
+    bool failed;
+} RememberedCheck;
+
+static bool rememberingChecks = false;
+static RememberedCheck *rememberedChecks = NULL;
+static int rememberedCheckCount = 0;
+static int rememberedChecksSize = 0;
+
 
 /*======================================================================*/
 void primeAltInfo(AltInfo *altInfo, int level, int parameter, int instance, int class)
@@ -202,35 +243,69 @@ static void addAlternativesFromParents(AltInfoArray altInfos, int verb, int leve
 }
 
 
-/*----------------------------------------------------------------------*/
-static void addAlternativesFromLocation(AltInfoArray altInfos, int verb, Aid location, AltEntryFinder finder) {
-    if (admin[location].location != 0)
-        addAlternativesFromLocation(altInfos, verb, admin[location].location, finder);
+/*======================================================================*/
+void startRememberingChecks(void)
+{
+    /* Every evaluation is shown when tracing or debugging */
+    rememberingChecks = !debugOption && !traceSectionOption && !traceSourceOption
+        && !traceInstructionOption && !tracePushOption && !traceStackOption;
+    rememberedCheckCount = 0;
+}
 
-    addAlternativesFromParents(altInfos, verb,
-                               LOCATION_LEVEL,
-                               NO_PARAMETER,
-                               instances[location].parent,
-                               location,
-                               finder);
 
-    addAlternative(altInfos, verb, LOCATION_LEVEL, NO_PARAMETER, NO_CLASS, location, finder);
+/*======================================================================*/
+void stopRememberingChecks(void)
+{
+    rememberingChecks = false;
+    rememberedCheckCount = 0;
 }
 
 
 /*----------------------------------------------------------------------*/
-static void addAlternativesFromParameter(AltInfoArray altInfos, int verb, Parameter parameters[], int parameterNumber, AltEntryFinder finder) {
-    Aid parent;
-    Aid theInstance = parameters[parameterNumber-1].instance;
+static RememberedCheck *rememberedCheck(AltEntry *alt)
+{
+    int i;
+
+    for (i = 0; i < rememberedCheckCount; i++)
+        if (rememberedChecks[i].alt == alt)
+            return &rememberedChecks[i];
+    return NULL;
+}
 
-    if (isLiteral(theInstance))
-        parent = literals[literalFromInstance(theInstance)].class;
-    else
-        parent = instances[theInstance].parent;
-    addAlternativesFromParents(altInfos, verb, PARAMETER_LEVEL, parameterNumber, parent, theInstance, finder);
 
-    if (!isLiteral(theInstance))
-        addAlternative(altInfos, verb, PARAMETER_LEVEL, parameterNumber, NO_CLASS, theInstance, finder);
+/*----------------------------------------------------------------------*/
+static bool checkFailedRemembering(AltInfo *altInfo)
+{
+    RememberedCheck *remembered = rememberedCheck(altInfo->alt);
+    ReadSet reads;
+    ReadSet *previousReadSet;
+    bool failed;
+
+    if (remembered != NULL) {
+        if (!remembered->dependent)
+            return remembered->failed;
+        return checkFailed(altInfo, DONT_EXECUTE_CHECK_BODY_ON_FAIL);
+    }
+
+    memset(&reads, 0, sizeof(reads));
+    previousReadSet = readSet;
+    readSet = &reads;
+    failed = checkFailed(altInfo, DONT_EXECUTE_CHECK_BODY_ON_FAIL);
+    readSet = previousReadSet;
+
+    if (rememberedCheckCount == rememberedChecksSize) {
+        int size = 2*rememberedChecksSize + 16;
+        RememberedCheck *grown = realloc(rememberedChecks, size*sizeof(RememberedCheck));
+        if (grown == NULL)
+            syserr("Out of memory.");
+        rememberedChecks = grown;
+        rememberedChecksSize = size;
+    }
+    remembered = &rememberedChecks[rememberedCheckCount++];
+    remembered->alt = altInfo->alt;
+    remembered->dependent = reads.untracked || reads.current;
+    remembered->failed = failed;
+    return failed;
 }
 
 
@@ -242,7 +317,10 @@ bool anyCheckFailed(AltInfoArray altInfo, bool execute)
     if (altInfo != NULL)
     for (altIndex = 0; !altInfo[altIndex].end; altIndex++) {
         current.instance = altInfo[altIndex].instance;
-        if (checkFailed(&altInfo[altIndex], execute))
+        if (rememberingChecks && !execute && altInfo[altIndex].alt != NULL && altInfo[altIndex].alt->checks != 0) {
+            if (checkFailedRemembering(&altInfo[altIndex]))
+                return true;
+        } else if (checkFailed(&altInfo[altIndex], execute))
         return true;
     }
     return false;
@@ -312,20 +390,140 @@ static AltEntry *alternativeFinder(int verb, int parameterNumber, int theInstanc
 }
 
 
+/*----------------------------------------------------------------------*/
+static int chainBucket(int verb, Aint parameterNumber, Aid holder) {
+    return ((unsigned)verb*31*31 + (unsigned)parameterNumber*31 + (unsigned)holder) % CHAIN_BUCKETS;
+}
+
+
+/*----------------------------------------------------------------------*/
+static AlternativeChain *newChain(int verb, Aint parameterNumber, Aid holder, bool literal) {
+    AlternativeChain *chain = allocate(sizeof(AlternativeChain));
+    AltInfo altInfos[1000];
+    bool meta = current.meta;
+    int i;
+
+    altInfos[0].end = true;
+    current.meta = false;
+    if (literal)
+        addAlternativesFromParents(altInfos, verb, PARAMETER_LEVEL, parameterNumber, holder, NO_INSTANCE, &alternativeFinder);
+    else if (holder == NO_INSTANCE)
+        addGlobalAlternatives(altInfos, verb, &alternativeFinder);
+    else {
+        addAlternativesFromParents(altInfos, verb, PARAMETER_LEVEL, parameterNumber, instances[holder].parent, holder, &alternativeFinder);
+        addAlternative(altInfos, verb, PARAMETER_LEVEL, parameterNumber, NO_CLASS, holder, &alternativeFinder);
+    }
+
+    chain->verb = verb;
+    chain->parameterNumber = parameterNumber;
+    chain->holder = holder;
+    chain->literal = literal;
+    chain->meta = current.meta;
+    chain->count = lastAltInfoIndex(altInfos)+1;
+    chain->alts = allocate((chain->count+1)*sizeof(AltEntry *));
+    chain->classes = allocate((chain->count+1)*sizeof(Aid));
+    for (i = 0; i < chain->count; i++) {
+        chain->alts[i] = altInfos[i].alt;
+        chain->classes[i] = altInfos[i].class;
+    }
+    current.meta = meta;
+    return chain;
+}
+
+
+/*----------------------------------------------------------------------*/
+static AlternativeChain *findChain(int verb, Aint parameterNumber, Aid holder, bool literal) {
+    int bucket = chainBucket(verb, parameterNumber, holder);
+    AlternativeChain *chain;
+
+    for (chain = chains[bucket]; chain != NULL; chain = chain->next)
+        if (chain->verb == verb && chain->parameterNumber == parameterNumber
+            && chain->holder == holder && chain->literal == literal)
+            return chain;
+
+    chain = newChain(verb, parameterNumber, holder, literal);
+    chain->next = chains[bucket];
+    chains[bucket] = chain;
+    return chain;
+}
+
+
 /*======================================================================*/
+void clearAlternativeCache(void) {
+    int bucket;
+
+    for (bucket = 0; bucket < CHAIN_BUCKETS; bucket++)
+        while (chains[bucket] != NULL) {
+            AlternativeChain *chain = chains[bucket];
+            chains[bucket] = chain->next;
+            deallocate(chain->alts);
+            deallocate(chain->classes);
+            deallocate(chain);
+        }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void growAltInfoBuffer(int size) {
+    AltInfo *grown = realloc(altInfoBuffer, size*sizeof(AltInfo));
+
+    if (grown == NULL)
+        syserr("Out of memory.");
+    altInfoBuffer = grown;
+    altInfoBufferSize = size;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void addChain(int *count, AlternativeChain *chain, int level, Aint parameterNumber, Aid theInstance) {
+    int i;
+
+    if (*count + chain->count + 1 > altInfoBufferSize)
+        growAltInfoBuffer(2*(*count + chain->count + 1));
+    for (i = 0; i < chain->count; i++) {
+        AltInfo *altInfo = &altInfoBuffer[(*count)++];
+        altInfo->alt = chain->alts[i];
+        primeAltInfo(altInfo, level, parameterNumber, theInstance, chain->classes[i]);
+    }
+    if (chain->meta)
+        current.meta = true;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void addChainsFromLocation(int *count, int verb, Aid location) {
+    if (admin.location[location] != 0)
+        addChainsFromLocation(count, verb, admin.location[location]);
+
+    addChain(count, findChain(verb, NO_PARAMETER, location, false), LOCATION_LEVEL, NO_PARAMETER, location);
+}
+
+
+/*======================================================================*/
+/* The alternatives are returned in an array which is reused by the
+   next call */
 AltInfo *findAllAlternatives(int verb, Parameter parameters[]) {
     int parameterNumber;
-    AltInfo altInfos[1000];
-    altInfos[0].end = true;
+    int count = 0;
 
-    addGlobalAlternatives(altInfos, verb, &alternativeFinder);
+    addChain(&count, findChain(verb, NO_PARAMETER, NO_INSTANCE, false), GLOBAL_LEVEL, NO_PARAMETER, NO_INSTANCE);
 
-    addAlternativesFromLocation(altInfos, verb, current.location, &alternativeFinder);
+    addChainsFromLocation(&count, verb, current.location);
 
     for (parameterNumber = 1; !isEndOfArray(&parameters[parameterNumber-1]); parameterNumber++) {
-        addAlternativesFromParameter(altInfos, verb, parameters, parameterNumber, &alternativeFinder);
+        Aid theInstance = parameters[parameterNumber-1].instance;
+        AlternativeChain *chain;
+        if (isLiteral(theInstance))
+            chain = findChain(verb, parameterNumber, literals[literalFromInstance(theInstance)].class, true);
+        else
+            chain = findChain(verb, parameterNumber, theInstance, false);
+        addChain(&count, chain, PARAMETER_LEVEL, parameterNumber, theInstance);
     }
-    return duplicateAltInfoArray(altInfos);
+
+    if (count + 1 > altInfoBufferSize)
+        growAltInfoBuffer(count + 1);
+    altInfoBuffer[count].end = true;
+    return altInfoBuffer;
 }
 
 
@@ -343,9 +541,6 @@ static bool possibleWithFinder(int verb, Parameter parameters[], AltInfoFinder *
     else
     anything = anythingToExecute(allAlternatives);
 
-    if (allAlternatives != NULL)
-      deallocate(allAlternatives);
-
     return(anything);
 }
 
@@ -57,8 +57,11 @@ extern bool canBeExecuted(AltInfo *altInfo);
 extern AltInfo *duplicateAltInfoArray(AltInfoArray altInfos);
 extern int lastAltInfoIndex(AltInfoArray altInfos);
 extern bool anyCheckFailed(AltInfoArray altInfos, bool execute);
+extern void startRememberingChecks(void);
+extern void stopRememberingChecks(void);
 extern bool anythingToExecute(AltInfoArray altInfos);
 extern bool possible(int verb, Parameter parameters[], ParameterPosition parameterPositions[]);
 extern AltInfo *findAllAlternatives(int verb, Parameter parameters[]);
+extern void clearAlternativeCache(void);
 
 #endif
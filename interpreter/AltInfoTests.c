@@ -119,3 +119,20 @@ Ensure(AltInfo, findVerbEntryCanMatchNegativeVerbCode) {
      * a verb with code 1 has -2 in the entry */
     assert_that(findVerbEntry(2, entries), is_equal_to(&entries[1]));
 }
+
+Ensure(AltInfo, findsSameCachedChainForSameVerbUntilCleared) {
+    AlternativeChain *chain;
+
+    header = allocate(sizeof(ACodeHeader));
+    header->verbTableAddress = 0;
+
+    chain = findChain(1, NO_PARAMETER, NO_INSTANCE, false);
+    assert_that(chain->count, is_equal_to(0));
+    assert_that(findChain(1, NO_PARAMETER, NO_INSTANCE, false), is_equal_to(chain));
+    assert_that(findChain(2, NO_PARAMETER, NO_INSTANCE, false), is_not_equal_to(chain));
+
+    clearAlternativeCache();
+    assert_that(chains[chainBucket(1, NO_PARAMETER, NO_INSTANCE)], is_null);
+    free(header);
+    header = NULL;
+}
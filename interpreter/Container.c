@@ -8,6 +8,7 @@
 #include "current.h"
 #include "msg.h"
 #include "output.h"
+#include "containment.h"
 
 
 /* PUBLIC DATA */
@@ -19,14 +20,20 @@ static int countInContainer(Aid containerIndex)	/* IN - the container to count i
 {
     int j = 0;
 
-    for (int instanceIndex = 1; instanceIndex <= header->instanceMax; instanceIndex++)
-        if (isIn(instanceIndex, containerIndex, DIRECT))
-            /* Then it's in this container also */
-            j++;
+    for (int instanceIndex = firstContained(containerIndex); instanceIndex != 0;
+         instanceIndex = nextContained(containerIndex, instanceIndex))
+        j++;
     return j;
 }
 
 
+/*----------------------------------------------------------------------*/
+/* Transitive containment, as in isIn(), does not look into locations */
+static bool looksInto(Aid container) {
+    return !isA(container, LOCATION);
+}
+
+
 /*----------------------------------------------------------------------*/
 static int sumAttributeInContainer(
     Aid containerIndex,        /* IN - the container to sum */
@@ -34,12 +41,16 @@ static int sumAttributeInContainer(
 ) {
     int sum = 0;
 
-    for (int instanceIndex = 1; instanceIndex <= header->instanceMax; instanceIndex++)
-        if (isIn(instanceIndex, containerIndex, TRANSITIVE)) {
-            /* We might find surprises in nested containers... */
-            if (hasAttribute(instanceIndex, attributeIndex))
-                sum = sum + getInstanceAttribute(instanceIndex, attributeIndex);
-        }
+    if (!looksInto(containerIndex))
+        return 0;
+
+    for (Aid instanceIndex = firstContained(containerIndex); instanceIndex != 0;
+         instanceIndex = nextContained(containerIndex, instanceIndex)) {
+        if (hasAttribute(instanceIndex, attributeIndex))
+            sum = sum + getInstanceAttribute(instanceIndex, attributeIndex);
+        /* We might find surprises in nested containers... */
+        sum = sum + sumAttributeInContainer(instanceIndex, attributeIndex);
+    }
     return sum;
 }
 
@@ -47,8 +58,11 @@ static int sumAttributeInContainer(
 /*----------------------------------------------------------------------*/
 static bool containerIsEmpty(int container)
 {
-    for (int i = 1; i <= header->instanceMax; i++)
-        if (isDescribable(i) && isIn(i, container, TRANSITIVE))
+    if (!looksInto(container))
+        return true;
+
+    for (Aid i = firstContained(container); i != 0; i = nextContained(container, i))
+        if (isDescribable(i) || !containerIsEmpty(i))
             return false;
     return true;
 }
@@ -99,14 +113,35 @@ bool passesContainerLimits(Aint theContainerInstance, Aint theAddedInstance) {
 }
 
 
+/*----------------------------------------------------------------------*/
+static int countTransitively(Aid container) {
+    int count = 0;
+
+    if (!looksInto(container))
+        return 0;
+
+    for (Aid i = firstContained(container); i != 0; i = nextContained(container, i))
+        count = count + 1 + countTransitively(i);
+    return count;
+}
+
+
 /*======================================================================*/
 int containerSize(int container, ATrans trans) {
     Aint count = 0;
 
-    for (Aid i = 1; i <= header->instanceMax; i++) {
-        if (isIn(i, container, trans))
-            count++;
-    }
+    if (!isAContainer(container))
+        syserr("IN in a non-container.");
+
+    if (trans == DIRECT)
+        return countInContainer(container);
+
+    if (looksInto(container))
+        for (Aid i = firstContained(container); i != 0; i = nextContained(container, i)) {
+            if (trans == TRANSITIVE)
+                count++;
+            count += countTransitively(i);
+        }
     return count;
 }
 
@@ -124,27 +159,25 @@ void list(int container)
     containerProps = instances[container].container;
     if (containerProps == 0) syserr("Trying to list something not a container.");
 
-    for (Aid i = 1; i <= header->instanceMax; i++) {
+    /* We can only see objects and actors directly in this container... */
+    for (Aid i = firstContained(container); i != 0; i = nextContained(container, i)) {
         if (isDescribable(i)) {
-            /* We can only see objects and actors directly in this container... */
-            if (admin[i].location == container) { /* Yes, it's in this container */
-                if (found == 0) {
-                    if (containers[containerProps].header != 0)
-                        interpret(containers[containerProps].header);
-                    else {
-                        if (isAActor(containers[containerProps].owner))
-                            printMessageWithInstanceParameter(M_CARRIES, containers[containerProps].owner);
-                        else
-                            printMessageWithInstanceParameter(M_CONTAINS, containers[containerProps].owner);
-                    }
-                    foundInstance[0] = i;
-                } else if (found == 1)
-                    foundInstance[1] = i;
+            if (found == 0) {
+                if (containers[containerProps].header != 0)
+                    interpret(containers[containerProps].header);
                 else {
-                    printMessageWithInstanceParameter(M_CONTAINS_COMMA, i);
+                    if (isAActor(containers[containerProps].owner))
+                        printMessageWithInstanceParameter(M_CARRIES, containers[containerProps].owner);
+                    else
+                        printMessageWithInstanceParameter(M_CONTAINS, containers[containerProps].owner);
                 }
-                found++;
+                foundInstance[0] = i;
+            } else if (found == 1)
+                foundInstance[1] = i;
+            else {
+                printMessageWithInstanceParameter(M_CONTAINS_COMMA, i);
             }
+            found++;
         }
     }
 
@@ -91,7 +91,7 @@ void look(void)
 
     /* Set describe flag for all objects and actors */
     for (i = 1; i <= header->instanceMax; i++)
-        admin[i].alreadyDescribed = false;
+        admin.alreadyDescribed[i] = false;
 
     if (anyOutput)
         para();
@@ -68,6 +68,12 @@ bool stateStackIsEmpty(StateStackP stateStack) {
 }
 
 
+/*======================================================================*/
+int stateStackDepth(StateStackP stateStack) {
+	return stateStack->stackPointer;
+}
+
+
 /*----------------------------------------------------------------------*/
 static void ensureSpaceForGameState(StateStackP stack)
 {
@@ -106,3 +112,18 @@ void popGameState(StateStackP stateStack, void *gameState, char** playerCommand)
         *playerCommand = stateStack->commands[stateStack->stackPointer];
     }
 }
+
+
+/*======================================================================*/
+void removeOldestGameState(StateStackP stateStack, void *gameState, char** playerCommand) {
+    if (stateStack->stackPointer == 0)
+        syserr("Removing GameState from empty stack");
+    else {
+        memcpy(gameState, stateStack->states[0], stateStack->elementSize);
+        deallocate(stateStack->states[0]);
+        *playerCommand = stateStack->commands[0];
+        stateStack->stackPointer--;
+        memmove(&stateStack->states[0], &stateStack->states[1], stateStack->stackPointer*sizeof(void *));
+        memmove(&stateStack->commands[0], &stateStack->commands[1], stateStack->stackPointer*sizeof(char *));
+    }
+}
@@ -17,8 +17,10 @@ typedef struct StateStackStructure *StateStackP;
 /* FUNCTIONS */
 extern StateStackP createStateStack(int elementSize);
 extern bool stateStackIsEmpty(StateStackP stateStack);
+extern int stateStackDepth(StateStackP stateStack);
 extern void pushGameState(StateStackP stateStack, void *state);
 extern void popGameState(StateStackP stateStack, void *state, char **playerCommandPointer);
+extern void removeOldestGameState(StateStackP stateStack, void *state, char **playerCommandPointer);
 extern void attachPlayerCommandsToLastState(StateStackP stateStack, char *playerCommand);
 extern void deleteStateStack(StateStackP stateStack);
 
@@ -12,6 +12,7 @@ struct game_state {
     /* Event queue */
     EventQueueEntry *eventQueue;
     int eventQueueTop;		/* Event queue top pointer */
+    bool eventsChanged;
 
     /* Scores */
     int score;
@@ -25,6 +26,11 @@ struct game_state {
        saving of attributes, instead they require special storage */
     Set **sets;			/* Array of set pointers */
     char **strings;		/* Array of string pointers */
+
+    /* Undo journal */
+    void *changes;
+    int changeCount;
+    long size;
 };
 
 
@@ -111,3 +117,23 @@ Ensure(StateStack, willGenerateSyserrorWhenPoppingFromEmptyStack) {
 
     assert_true(syserrCalled);
 }
+
+Ensure(StateStack, canRemoveTheOldestGameState) {
+    GameState oldest;
+    char *playerCommand;
+
+    gameState.score = 1;
+    pushGameState(stateStack, &gameState);
+    attachPlayerCommandsToLastState(stateStack, "first");
+    gameState.score = 2;
+    pushGameState(stateStack, &gameState);
+
+    removeOldestGameState(stateStack, &oldest, &playerCommand);
+    assert_equal(oldest.score, 1);
+    assert_string_equal(playerCommand, "first");
+    assert_equal(stateStackDepth(stateStack), 1);
+
+    popGameState(stateStack, &oldest, &playerCommand);
+    assert_equal(oldest.score, 2);
+    assert_true(stateStackIsEmpty(stateStack));
+}
@@ -20,13 +20,9 @@
 /*----------------------------------------------------------------------*/
 static void executeCommand(int verb, Parameter parameters[])
 {
-    static AltInfo *altInfos = NULL; /* Need to survive lots of different exits...*/
+    AltInfo *altInfos;
     int altIndex;
 
-    /* Did we leave anything behind last time... */
-    if (altInfos != NULL)
-        free(altInfos);
-
     altInfos = findAllAlternatives(verb, parameters);
 
     if (anyCheckFailed(altInfos, EXECUTE_CHECK_BODY_ON_FAIL))
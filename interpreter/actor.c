@@ -29,9 +29,9 @@
 ScriptEntry *scriptOf(int actor) {
     ScriptEntry *scr;
 
-    if (admin[actor].script != 0) {
+    if (admin.script[actor] != 0) {
         for (scr = (ScriptEntry *) pointerTo(header->scriptTableAddress); !isEndOfArray(scr); scr++)
-            if (scr->code == admin[actor].script)
+            if (scr->code == admin.script[actor])
                 break;
         if (!isEndOfArray(scr))
             return scr;
@@ -48,7 +48,7 @@ StepEntry *stepOf(int actor) {
     if (scr == NULL) return NULL;
 
     step = (StepEntry*)pointerTo(scr->steps);
-    step = &step[admin[actor].step];
+    step = &step[admin.step[actor]];
 
     return step;
 }
@@ -69,5 +69,5 @@ void describeActor(int actor)
         if (instances[actor].container != 0)
             describeContainer(actor);
     }
-    admin[actor].alreadyDescribed = true;
+    admin.alreadyDescribed[actor] = true;
 }
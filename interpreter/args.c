@@ -32,6 +32,8 @@
 /* The files and filenames */
 char *adventureName;        /* The name of the game */
 char *adventureFileName;
+char *batchFileName = NULL; /* Manifest of sessions to replay, if any */
+char *replayFileName = NULL; /* Command log to restore the session from, if any */
 
 /*======================================================================*/
 char *gameName(char *fullPathName) {
@@ -74,6 +76,24 @@ static char *addAcodeExtension(char *adventureFileName) {
 }
 
 
+/*======================================================================*/
+/* Set the game to run, replacing any previous one */
+void setAdventureFileName(char *fileName) {
+    if (adventureFileName != NULL)
+        free(adventureFileName);
+    adventureFileName = addAcodeExtension(strdup(fileName));
+    adventureName = gameName(adventureFileName);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void unrecognizedSwitch(char *argument, char *programName) {
+    printf("Unrecognized switch, -%s\n", &argument[1]);
+    usage(programName);
+    terminate(0);
+}
+
+
 /*----------------------------------------------------------------------*/
 static void version(void) {
 #if (BUILD+0) != 0
@@ -100,10 +120,16 @@ static void switches(int argc, char *argv[])
                     terminate(0);
                     break;
                 case 'i':
-                    encodingOption = ENCODING_ISO;
+                    if (strcasecmp(argument, "-image") == 0)
+                        imageOption = true;
+                    else
+                        encodingOption = ENCODING_ISO;
                     break;
                 case 'u':
-                    encodingOption = ENCODING_UTF;
+                    if (strncasecmp(argument, "-undo", 5) == 0 && isdigit((int)argument[5]))
+                        undoLevelsOption = atoi(&argument[5]);
+                    else
+                        encodingOption = ENCODING_UTF;
                     break;
                 case 'e':
                     ignoreErrorOption = true;
@@ -140,14 +166,35 @@ static void switches(int argc, char *argv[])
                     statusLineOption = false;
                     break;
                 case 'c':
-                    commandLogOption = true;
+                    if (strncasecmp(argument, "-cache", 6) == 0 && isdigit((int)argument[6]))
+                        textCacheOption = atoi(&argument[6]);
+                    else if (strcasecmp(argument, "-checkrules") == 0)
+                        checkRulesOption = true;
+                    else
+                        commandLogOption = true;
                     break;
                 case 'p':
-                    nopagingOption = true;
+                    if (strcasecmp(argument, "-profile") == 0)
+                        profileOption = true;
+                    else
+                        nopagingOption = true;
                     break;
                 case 'r':
-                    regressionTestOption = true;
-                    statusLineOption = false;
+                    if (strcasecmp(argument, "-replay") == 0) {
+                        if (i+1 >= argc)
+                            unrecognizedSwitch(argument, argv[0]);
+                        replayFileName = strdup(argv[++i]);
+                    } else {
+                        regressionTestOption = true;
+                        statusLineOption = false;
+                    }
+                    break;
+                case 'b':
+                    if (strncasecmp(argument, "-batch", 6) != 0 || i+1 >= argc)
+                        unrecognizedSwitch(argument, argv[0]);
+                    if (isdigit((int)argument[6]))
+                        batchWorkersOption = atoi(&argument[6]);
+                    batchFileName = strdup(argv[++i]);
                     break;
                 case '-':
                     if (strcasecmp(&argument[2], "version") == 0) {
@@ -157,9 +204,7 @@ static void switches(int argc, char *argv[])
                     }
                     /* else fall-through */
                 default:
-                    printf("Unrecognized switch, -%s\n", &argument[1]);
-                    usage(argv[0]);
-                    terminate(0);
+                    unrecognizedSwitch(argument, argv[0]);
                 }
         } else {
 
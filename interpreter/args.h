@@ -18,7 +18,10 @@
 /* DATA */
 extern char *adventureName; /* The name of the game */
 extern char *adventureFileName;
+extern char *batchFileName;
+extern char *replayFileName;
 
 /* FUNCTIONS */
 extern char *gameName(char fullPathName[]);
+extern void setAdventureFileName(char *fileName);
 extern void args(int argc, char *argv[]);
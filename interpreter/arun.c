@@ -14,6 +14,7 @@
 #include "memory.h"
 #include "output.h"
 #include "args.h"
+#include "batch.h"
 
 #include "alan.version.h"
 
@@ -56,6 +57,9 @@ int main(int argc, char *argv[])
 #else
     args(argc, argv);
 
+    if (batchFileName != NULL)
+        runBatch(batchFileName);
+
     if (adventureFileName == NULL || strcmp(adventureFileName, "") == 0) {
         printf("You should supply a game file to play.\n");
         usage(PROGNAME);
@@ -3,6 +3,30 @@
 #include "syserr.h"
 #include "current.h"
 #include "lists.h"
+#include "memory.h"
+#include "instance.h"
+
+
+/* PRIVATE TYPES */
+/* The order of the attribute codes of an instance, shared by all
+   instances having their attributes in the same order (normally all
+   instances of the same class), giving the slot of each code */
+typedef struct AttributeLayout {
+    int count;                  /* Number of attributes */
+    int maxCode;                /* Highest attribute code */
+    int *codes;                 /* The codes in slot order */
+    int *slot;                  /* Slot for each code, or NO_SLOT */
+    unsigned int hash;
+    struct AttributeLayout *next;
+} AttributeLayout;
+
+#define NO_SLOT (-1)
+
+
+/* PRIVATE DATA */
+static AttributeLayout **layoutOf = NULL; /* Layout for each instance */
+static AttributeLayout *layouts = NULL;   /* All the different layouts */
+static int indexedMax = 0;
 
 
 /*----------------------------------------------------------------------*/
@@ -18,6 +42,126 @@ static AttributeEntry *lookupAttribute(AttributeEntry *attributeTable, int attri
 }
 
 
+/*----------------------------------------------------------------------*/
+static unsigned int hashOfCodes(AttributeEntry *attributeTable, int *count) {
+    AttributeEntry *attribute;
+    unsigned int hash = 0;
+
+    *count = 0;
+    for (attribute = attributeTable; !isEndOfArray(attribute); attribute++) {
+        hash = hash*31 + attribute->code;
+        (*count)++;
+    }
+    return hash;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool sameCodes(AttributeLayout *layout, AttributeEntry *attributeTable) {
+    int i;
+
+    for (i = 0; i < layout->count; i++)
+        if (layout->codes[i] != attributeTable[i].code)
+            return false;
+    return true;
+}
+
+
+/*----------------------------------------------------------------------*/
+static AttributeLayout *newLayout(AttributeEntry *attributeTable, int count, unsigned int hash) {
+    AttributeLayout *layout = allocate(sizeof(AttributeLayout));
+    int i;
+
+    layout->count = count;
+    layout->hash = hash;
+    layout->codes = allocate((count+1)*sizeof(int));
+    layout->maxCode = 0;
+    for (i = 0; i < count; i++) {
+        layout->codes[i] = attributeTable[i].code;
+        if (attributeTable[i].code > layout->maxCode)
+            layout->maxCode = attributeTable[i].code;
+    }
+
+    layout->slot = allocate((layout->maxCode+1)*sizeof(int));
+    for (i = 0; i <= layout->maxCode; i++)
+        layout->slot[i] = NO_SLOT;
+    /* Backwards, so that the first of any duplicate codes is found */
+    for (i = count-1; i >= 0; i--)
+        if (layout->codes[i] >= 0)
+            layout->slot[layout->codes[i]] = i;
+
+    layout->next = layouts;
+    layouts = layout;
+    return layout;
+}
+
+
+/*----------------------------------------------------------------------*/
+static AttributeLayout *internLayout(AttributeEntry *attributeTable) {
+    AttributeLayout *layout;
+    int count;
+    unsigned int hash = hashOfCodes(attributeTable, &count);
+
+    for (layout = layouts; layout != NULL; layout = layout->next)
+        if (layout->hash == hash && layout->count == count && sameCodes(layout, attributeTable))
+            return layout;
+    return newLayout(attributeTable, count, hash);
+}
+
+
+/*======================================================================*/
+void freeAttributeIndex(void) {
+    while (layouts != NULL) {
+        AttributeLayout *next = layouts->next;
+        deallocate(layouts->codes);
+        deallocate(layouts->slot);
+        deallocate(layouts);
+        layouts = next;
+    }
+    if (layoutOf != NULL)
+        deallocate(layoutOf);
+    layoutOf = NULL;
+    indexedMax = 0;
+}
+
+
+/*======================================================================*/
+/* Find the layout of the attributes of all instances. Only the values
+   of attributes ever change, so this need only be done when the
+   attribute area has been created. */
+void indexAttributes(void) {
+    int instance;
+
+    freeAttributeIndex();
+
+    indexedMax = header->instanceMax;
+    layoutOf = allocate((indexedMax+1)*sizeof(AttributeLayout *));
+    for (instance = 1; instance <= indexedMax; instance++)
+        layoutOf[instance] = internLayout(admin.attributes[instance]);
+}
+
+
+/*======================================================================*/
+/* The attribute entry of an instance, found directly through its layout */
+AttributeEntry *attributeOf(int instance, int attributeCode) {
+    AttributeLayout *layout;
+    int slot;
+
+    if (layoutOf == NULL)
+        indexAttributes();
+    if (instance > indexedMax)
+        return lookupAttribute(admin.attributes[instance], attributeCode);
+
+    layout = layoutOf[instance];
+    if (attributeCode < 0 || attributeCode > layout->maxCode)
+        return NULL;
+    slot = layout->slot[attributeCode];
+    if (slot == NO_SLOT)
+        return NULL;
+    return &admin.attributes[instance][slot];
+}
+
+
 /*======================================================================*/
 bool attributeExists(AttributeEntry *attributeTable, int attributeCode)
 {
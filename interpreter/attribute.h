@@ -12,6 +12,10 @@
 /* DATA */
 
 /* FUNCTIONS */
+extern void indexAttributes(void);
+extern void freeAttributeIndex(void);
+extern AttributeEntry *attributeOf(int instance, int attributeCode);
+
 extern bool attributeExists(AttributeEntry *attributeTable, int attributeCode);
 extern Aword getAttribute(AttributeEntry *attributeTable, int attributeCode);
 extern void setAttribute(AttributeEntry *attributeTable, int attributeCode, Aptr newValue);
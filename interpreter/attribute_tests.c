@@ -0,0 +1,98 @@
+#include <cgreen/cgreen.h>
+#include <cgreen/mocks.h>
+
+#include "attribute.h"
+
+#include "memory.h"
+#include "lists.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "current.mock"
+#include "instance.mock"
+
+
+#define MAX_ATTRIBUTES 4
+
+static AttributeEntry tables[4][MAX_ATTRIBUTES+1];
+
+static void given_instance_with_attributes(int instance, int codes[], int count) {
+    for (int i = 0; i < count; i++) {
+        tables[instance][i].code = codes[i];
+        tables[instance][i].value = 100*instance+codes[i];
+    }
+    setEndOfArray(&tables[instance][count]);
+    admin.attributes[instance] = tables[instance];
+}
+
+
+Describe(Attribute);
+BeforeEach(Attribute) {
+    header = allocate(sizeof(ACodeHeader));
+    header->instanceMax = 3;
+    admin.attributes = allocate(4*sizeof(AttributeEntry *));
+}
+AfterEach(Attribute) {
+    freeAttributeIndex();
+    free(admin.attributes);
+    free(header);
+}
+
+
+Ensure(Attribute, finds_attributes_of_each_instance) {
+    int codes1[] = {3, 1, 4};
+    int codes2[] = {1, 3, 4};
+    int codes3[] = {2};
+    given_instance_with_attributes(1, codes1, 3);
+    given_instance_with_attributes(2, codes2, 3);
+    given_instance_with_attributes(3, codes3, 1);
+    indexAttributes();
+
+    assert_that(attributeOf(1, 3)->value, is_equal_to(103));
+    assert_that(attributeOf(1, 4)->value, is_equal_to(104));
+    assert_that(attributeOf(2, 1)->value, is_equal_to(201));
+    assert_that(attributeOf(3, 2), is_equal_to(&tables[3][0]));
+    assert_that(attributeOf(3, 1), is_null);
+    assert_that(attributeOf(3, 5), is_null);
+}
+
+Ensure(Attribute, shares_layout_between_instances_with_same_codes) {
+    int codes[] = {2, 1};
+    given_instance_with_attributes(1, codes, 2);
+    given_instance_with_attributes(2, codes, 2);
+    given_instance_with_attributes(3, codes, 2);
+    indexAttributes();
+
+    assert_that(attributeOf(1, 1), is_equal_to(&tables[1][1]));
+    assert_that(attributeOf(2, 1), is_equal_to(&tables[2][1]));
+    assert_that(attributeOf(3, 2), is_equal_to(&tables[3][0]));
+}
+
+Ensure(Attribute, agrees_with_searching_the_attribute_list) {
+    int codes1[] = {3, 1, 4};
+    int codes2[] = {4};
+    int codes3[] = {2, 3};
+    given_instance_with_attributes(1, codes1, 3);
+    given_instance_with_attributes(2, codes2, 1);
+    given_instance_with_attributes(3, codes3, 2);
+    indexAttributes();
+
+    for (int instance = 1; instance <= 3; instance++)
+        for (int code = 0; code <= MAX_ATTRIBUTES+1; code++) {
+            assert_that(attributeOf(instance, code) != NULL,
+                        is_equal_to(attributeExists(admin.attributes[instance], code)));
+        }
+}
+
+Ensure(Attribute, sets_the_value_in_the_attribute_area) {
+    int codes[] = {1, 2};
+    given_instance_with_attributes(1, codes, 2);
+    given_instance_with_attributes(2, codes, 2);
+    given_instance_with_attributes(3, codes, 2);
+    indexAttributes();
+
+    attributeOf(2, 2)->value = 42;
+
+    assert_that(getAttribute(admin.attributes[2], 2), is_equal_to(42));
+    assert_that(getAttribute(admin.attributes[1], 2), is_equal_to(102));
+}
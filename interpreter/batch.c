@@ -0,0 +1,306 @@
+/*----------------------------------------------------------------------*\
+
+  batch
+
+  Replays the sessions listed in a manifest. Each line of the manifest
+  names a game, a file of player commands and, optionally, the output
+  expected from them:
+
+      <game> <input> [<expected>]
+
+  Empty lines and lines starting with '#' are ignored.
+
+  A game is loaded once for all consecutive sessions of it. Every
+  session is then played in a process of its own, forked from the
+  process holding the loaded game, so that it always starts from a
+  clean state. As many sessions as there are processors, or as given
+  with -batch<n>, are played at the same time.
+
+  The output of a session, on both stdout and stderr, is written next
+  to its input, with the extension replaced by '.output', and compared
+  to the expected output, if given. Sessions may end with a non-zero
+  exit status on purpose, so the status only decides the outcome of a
+  session without expected output, for which it is the only check.
+
+\*----------------------------------------------------------------------*/
+#include "batch.h"
+
+/* IMPORTS */
+#include <setjmp.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "args.h"
+#include "main.h"
+#include "memory.h"
+#include "options.h"
+#include "syserr.h"
+#include "utils.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_FORK
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
+
+
+/* CONSTANTS */
+#define OUTPUT_EXTENSION ".output"
+#define MANIFEST_LINE_LENGTH 1000
+#define SEPARATORS " \t\r\n"
+
+
+/* PRIVATE TYPES */
+typedef struct Session {
+    char *game;
+    char *input;
+    char *output;
+    char *expected;             /* NULL if not to be compared */
+} Session;
+
+#ifdef HAVE_FORK
+typedef struct Player {
+    pid_t pid;
+    Session *session;
+} Player;
+#endif
+
+
+/* PRIVATE DATA */
+#ifdef HAVE_FORK
+static jmp_buf loadFailed;
+
+static int passedCount = 0;
+static int failedCount = 0;
+static int crashedCount = 0;
+static int notLoadedCount = 0;
+static int notComparedCount = 0;
+
+
+/*----------------------------------------------------------------------*/
+static char *outputFileName(char *input) {
+    char *output = allocate(strlen(input)+strlen(OUTPUT_EXTENSION)+1);
+    char *extension;
+
+    strcpy(output, input);
+    extension = strrchr(output, '.');
+    if (extension != NULL && strchr(extension, '/') == NULL)
+        *extension = '\0';
+    strcat(output, OUTPUT_EXTENSION);
+    return output;
+}
+
+
+/*----------------------------------------------------------------------*/
+static Session *readManifest(char *manifestFileName, int *count) {
+    FILE *manifest = fopen(manifestFileName, "r");
+    char line[MANIFEST_LINE_LENGTH];
+    Session *sessions = NULL;
+    int allocated = 0;
+
+    if (manifest == NULL) {
+        printf("Can't open batch manifest '%s'.\n", manifestFileName);
+        terminate(1);
+    }
+
+    *count = 0;
+    while (fgets(line, sizeof(line), manifest) != NULL) {
+        char *game = strtok(line, SEPARATORS);
+        char *input, *expected;
+
+        if (game == NULL || game[0] == '#')
+            continue;
+        input = strtok(NULL, SEPARATORS);
+        expected = strtok(NULL, SEPARATORS);
+        if (input == NULL) {
+            printf("No input file for '%s' in batch manifest.\n", game);
+            continue;
+        }
+
+        if (*count == allocated) {
+            allocated = allocated == 0? 100 : 2*allocated;
+            sessions = realloc(sessions, allocated*sizeof(Session));
+            if (sessions == NULL)
+                syserr("Out of memory.");
+        }
+        sessions[*count].game = strdup(game);
+        sessions[*count].input = strdup(input);
+        sessions[*count].output = outputFileName(input);
+        sessions[*count].expected = expected == NULL? NULL : strdup(expected);
+        (*count)++;
+    }
+    fclose(manifest);
+    return sessions;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void failLoading(char *description) {
+    printf("Can't load '%s': %s\n", adventureFileName, description);
+    longjmp(loadFailed, 1);
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool loadSessionGame(char *game) {
+    bool loaded;
+
+    unloadGame();
+    setAdventureFileName(game);
+
+    /* A game that can't be loaded should not end the batch */
+    setSyserrHandler(failLoading);
+    if (setjmp(loadFailed) == 0) {
+        loadGame();
+        loaded = true;
+    } else
+        loaded = false;
+    setSyserrHandler(NULL);
+    return loaded;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void playSession(Session *session) {
+    if (freopen(session->input, "r", stdin) == NULL) {
+        printf("Can't open input file '%s'.\n", session->input);
+        terminate(1);
+    }
+    if (freopen(session->output, "w", stdout) == NULL) {
+        printf("Can't create output file '%s'.\n", session->output);
+        terminate(1);
+    }
+    dup2(fileno(stdout), fileno(stderr));
+
+    play();
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool startSession(Player *player, Session *session) {
+    pid_t pid;
+
+    fflush(stdout);             /* Or the session would repeat anything pending */
+    pid = fork();
+    if (pid == 0)
+        playSession(session);
+    if (pid < 0) {
+        printf("Can't start a session for '%s'.\n", session->input);
+        crashedCount++;
+        return false;
+    }
+    player->pid = pid;
+    player->session = session;
+    return true;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool sameContents(char *fileName, char *otherFileName) {
+    FILE *file = fopen(fileName, "rb");
+    FILE *other = fopen(otherFileName, "rb");
+    bool same = file != NULL && other != NULL;
+    char buffer[4096], otherBuffer[4096];
+    size_t length;
+
+    while (same && (length = fread(buffer, 1, sizeof(buffer), file)) > 0)
+        same = fread(otherBuffer, 1, length, other) == length
+            && memcmp(buffer, otherBuffer, length) == 0;
+    if (same)
+        same = fgetc(other) == EOF;
+
+    if (file != NULL)
+        fclose(file);
+    if (other != NULL)
+        fclose(other);
+    return same;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void reportSession(Session *session, int status) {
+    if (WIFSIGNALED(status)) {
+        printf("CRASHED %s (signal %d)\n", session->input, WTERMSIG(status));
+        crashedCount++;
+    } else if (session->expected == NULL) {
+        if (WEXITSTATUS(status) != 0) {
+            printf("FAILED %s (exit status %d)\n", session->input, WEXITSTATUS(status));
+            failedCount++;
+        } else
+            notComparedCount++;
+    } else if (sameContents(session->output, session->expected))
+        passedCount++;
+    else {
+        if (WEXITSTATUS(status) != 0)
+            printf("FAILED %s (exit status %d)\n", session->input, WEXITSTATUS(status));
+        else
+            printf("FAILED %s\n", session->input);
+        failedCount++;
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void awaitSession(Player players[], int *playing) {
+    int status;
+    pid_t pid = wait(&status);
+    int i;
+
+    if (pid < 0)
+        syserr("Lost track of the sessions in the batch.");
+    for (i = 0; i < *playing; i++)
+        if (players[i].pid == pid) {
+            reportSession(players[i].session, status);
+            players[i] = players[--(*playing)];
+            return;
+        }
+}
+
+
+/*----------------------------------------------------------------------*/
+static int processorCount(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0? count : 1;
+}
+#endif
+
+
+/*======================================================================*/
+/* Play all sessions in the manifest and report how they went, this
+   never returns */
+void runBatch(char *manifestFileName) {
+#ifdef HAVE_FORK
+    int sessionCount;
+    Session *sessions = readManifest(manifestFileName, &sessionCount);
+    int workers = batchWorkersOption > 0? batchWorkersOption : processorCount();
+    Player *players = allocate(workers*sizeof(Player));
+    int playing = 0;
+    bool loaded = false;
+    int i;
+
+    for (i = 0; i < sessionCount; i++) {
+        if (i == 0 || strcmp(sessions[i].game, sessions[i-1].game) != 0)
+            loaded = loadSessionGame(sessions[i].game);
+        if (!loaded) {
+            notLoadedCount++;
+            continue;
+        }
+        if (playing == workers)
+            awaitSession(players, &playing);
+        if (startSession(&players[playing], &sessions[i]))
+            playing++;
+    }
+    while (playing > 0)
+        awaitSession(players, &playing);
+
+    printf("%d sessions: %d passed, %d failed, %d crashed, %d not loaded, %d not compared\n",
+           sessionCount, passedCount, failedCount, crashedCount, notLoadedCount, notComparedCount);
+    unloadGame();
+    exit(failedCount+crashedCount+notLoadedCount == 0? EXIT_SUCCESS : EXIT_FAILURE);
+#else
+    printf("Batch mode is not available on this platform.\n");
+    terminate(1);
+#endif
+}
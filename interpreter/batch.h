@@ -0,0 +1,28 @@
+#ifndef BATCH_H_
+#define BATCH_H_
+/*----------------------------------------------------------------------*\
+
+  batch
+
+  Replaying many sessions, listed in a manifest, in parallel and
+  without reloading the game for each one, with -batch.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern void runBatch(char *manifestFileName);
+
+#endif /* BATCH_H_ */
@@ -0,0 +1,119 @@
+/*----------------------------------------------------------------------*\
+
+  bitset
+
+  Sets of small non-negative integers as bits in an array of words.
+
+  The set and its words are one temporary allocation. Members outside
+  the size of a set are never in it, and are ignored when added.
+
+\*----------------------------------------------------------------------*/
+#include "bitset.h"
+
+/* IMPORTS */
+#include "lists.h"
+#include "memory.h"
+
+
+/* CONSTANTS */
+#define BITS_PER_WORD (8*sizeof(BitsetWord))
+
+
+/*----------------------------------------------------------------------*/
+static int wordsFor(int size) {
+    return (size + BITS_PER_WORD - 1)/BITS_PER_WORD;
+}
+
+
+/*----------------------------------------------------------------------*/
+static int bitsIn(BitsetWord word) {
+#ifdef __GNUC__
+    return __builtin_popcountll(word);
+#else
+    int count = 0;
+
+    for (; word != 0; word &= word-1)
+        count++;
+    return count;
+#endif
+}
+
+
+/*======================================================================*/
+Bitset *newBitset(int size) {
+    Bitset *set = allocateTemporary(sizeof(Bitset) + wordsFor(size)*sizeof(BitsetWord));
+
+    set->size = size;
+    set->words = (BitsetWord *)(set+1);
+    return set;
+}
+
+
+/*======================================================================*/
+void freeBitset(Bitset *set) {
+    deallocate(set);
+}
+
+
+/*======================================================================*/
+void clearBitset(Bitset *set) {
+    memset(set->words, 0, wordsFor(set->size)*sizeof(BitsetWord));
+}
+
+
+/*======================================================================*/
+void addToBitset(Bitset *set, int member) {
+    if (member >= 0 && member < set->size)
+        set->words[member/BITS_PER_WORD] |= (BitsetWord)1 << (member%BITS_PER_WORD);
+}
+
+
+/*======================================================================*/
+void addReferencesToBitset(Bitset *set, Aint references[]) {
+    int i;
+
+    for (i = 0; !isEndOfArray(&references[i]); i++)
+        addToBitset(set, references[i]);
+}
+
+
+/*======================================================================*/
+bool inBitset(Bitset *set, int member) {
+    return member >= 0 && member < set->size
+        && (set->words[member/BITS_PER_WORD] & ((BitsetWord)1 << (member%BITS_PER_WORD))) != 0;
+}
+
+
+/*======================================================================*/
+int countBitset(Bitset *set) {
+    int count = 0;
+    int w;
+
+    for (w = 0; w < wordsFor(set->size); w++)
+        count += bitsIn(set->words[w]);
+    return count;
+}
+
+
+/*======================================================================*/
+/* Keep only the members also in the other set */
+void intersectBitsets(Bitset *set, Bitset *other) {
+    int words = wordsFor(set->size);
+    int otherWords = wordsFor(other->size);
+    int w;
+
+    for (w = 0; w < words; w++)
+        set->words[w] &= w < otherWords? other->words[w] : 0;
+}
+
+
+/*======================================================================*/
+/* Remove the members that are in the other set */
+void subtractBitsets(Bitset *set, Bitset *other) {
+    int words = wordsFor(set->size);
+    int otherWords = wordsFor(other->size);
+    int w;
+
+    for (w = 0; w < words && w < otherWords; w++)
+        set->words[w] &= ~other->words[w];
+}
@@ -0,0 +1,45 @@
+#ifndef BITSET_H_
+#define BITSET_H_
+/*----------------------------------------------------------------------*\
+
+  bitset
+
+  Sets of small non-negative integers, such as instance ids, kept as
+  bits in an array of words so that they can be intersected and
+  subtracted a word at a time. Bitsets are temporaries, they are only
+  needed during a player command.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include <stdint.h>
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+typedef uint64_t BitsetWord;
+
+typedef struct Bitset {
+    int size;                   /* Members are 0..size-1 */
+    BitsetWord *words;
+} Bitset;
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern Bitset *newBitset(int size);
+extern void freeBitset(Bitset *set);
+extern void clearBitset(Bitset *set);
+extern void addToBitset(Bitset *set, int member);
+extern void addReferencesToBitset(Bitset *set, Aint references[]);
+extern bool inBitset(Bitset *set, int member);
+extern int countBitset(Bitset *set);
+extern void intersectBitsets(Bitset *set, Bitset *other);
+extern void subtractBitsets(Bitset *set, Bitset *other);
+
+#endif /* BITSET_H_ */
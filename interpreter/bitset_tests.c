@@ -0,0 +1,113 @@
+#include <cgreen/cgreen.h>
+#include <cgreen/mocks.h>
+
+#include "bitset.h"
+
+/* Dependencies */
+#include "lists.h"
+
+/* Mocks */
+#include "syserr.mock"
+#include "instance.mock"
+
+
+Describe(Bitset);
+BeforeEach(Bitset) {}
+AfterEach(Bitset) {}
+
+
+Ensure(Bitset, is_empty_when_new) {
+    Bitset *set = newBitset(100);
+
+    assert_that(countBitset(set), is_equal_to(0));
+    assert_that(!inBitset(set, 0));
+    assert_that(!inBitset(set, 99));
+    freeBitset(set);
+}
+
+Ensure(Bitset, has_added_members_in_any_word) {
+    Bitset *set = newBitset(200);
+
+    addToBitset(set, 0);
+    addToBitset(set, 63);
+    addToBitset(set, 64);
+    addToBitset(set, 199);
+    addToBitset(set, 64);
+
+    assert_that(countBitset(set), is_equal_to(4));
+    assert_that(inBitset(set, 63));
+    assert_that(inBitset(set, 64));
+    assert_that(inBitset(set, 199));
+    assert_that(!inBitset(set, 1));
+    freeBitset(set);
+}
+
+Ensure(Bitset, ignores_members_outside_its_size) {
+    Bitset *set = newBitset(10);
+
+    addToBitset(set, 10);
+    addToBitset(set, -1);
+
+    assert_that(countBitset(set), is_equal_to(0));
+    assert_that(!inBitset(set, 10));
+    freeBitset(set);
+}
+
+Ensure(Bitset, can_add_references) {
+    Aint references[4] = {3, 5, 70, 0};
+    Bitset *set = newBitset(100);
+
+    setEndOfArray(&references[3]);
+    addReferencesToBitset(set, references);
+
+    assert_that(countBitset(set), is_equal_to(3));
+    assert_that(inBitset(set, 70));
+    freeBitset(set);
+}
+
+Ensure(Bitset, can_be_cleared) {
+    Bitset *set = newBitset(100);
+
+    addToBitset(set, 70);
+    clearBitset(set);
+
+    assert_that(countBitset(set), is_equal_to(0));
+    freeBitset(set);
+}
+
+Ensure(Bitset, keeps_only_common_members_when_intersected) {
+    Bitset *set = newBitset(200);
+    Bitset *other = newBitset(100);
+
+    addToBitset(set, 5);
+    addToBitset(set, 70);
+    addToBitset(set, 150);
+    addToBitset(other, 70);
+    addToBitset(other, 6);
+
+    intersectBitsets(set, other);
+
+    assert_that(countBitset(set), is_equal_to(1));
+    assert_that(inBitset(set, 70));
+    freeBitset(other);
+    freeBitset(set);
+}
+
+Ensure(Bitset, removes_members_of_the_other_when_subtracted) {
+    Bitset *set = newBitset(200);
+    Bitset *other = newBitset(100);
+
+    addToBitset(set, 5);
+    addToBitset(set, 70);
+    addToBitset(set, 150);
+    addToBitset(other, 70);
+    addToBitset(other, 6);
+
+    subtractBitsets(set, other);
+
+    assert_that(countBitset(set), is_equal_to(2));
+    assert_that(inBitset(set, 5));
+    assert_that(inBitset(set, 150));
+    freeBitset(other);
+    freeBitset(set);
+}
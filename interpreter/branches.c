@@ -0,0 +1,392 @@
+/*----------------------------------------------------------------------*\
+
+  branches
+
+  Precomputed targets for the control flow instructions.
+
+  The Acode has no jump addresses, the interpreter has to find the
+  matching ELSE, ENDIF, LOOPEND etc. by scanning the code and
+  counting nesting levels. To avoid doing that every time an IF is
+  false or a LOOP iterates we walk all code reachable from the tables
+  once after loading and record, for each control flow instruction,
+  the address the interpreter should continue at:
+
+    IF                  after the matching ELSE or ENDIF
+    ELSE                after the matching ENDIF
+    LOOP, LOOPNEXT      at the matching LOOPEND
+    LOOPEND             at the matching LOOP
+    DEPEXEC             after the next DEPCASE or DEPELSE on the
+                        same level, or at the ENDDEP
+    DEPCASE, DEPELSE    at the matching ENDDEP
+
+  An address of 0 means "not indexed" and the interpreter will fall
+  back to scanning.
+
+\*----------------------------------------------------------------------*/
+#include "branches.h"
+
+/* IMPORTS */
+#include "lists.h"
+#include "memory.h"
+#include "checkentry.h"
+#include "msg.h"
+#include "compatibility.h"
+
+
+/* CONSTANTS */
+#define MAXNESTING 100
+
+
+/* PRIVATE DATA */
+static Aaddr *branchTargets = NULL;
+static int branchTargetsSize = 0;
+
+
+/*----------------------------------------------------------------------*/
+static bool isInstruction(Aaddr adr, InstClass instruction) {
+    return I_CLASS(memory[adr]) == (Aword)C_STMOP && I_OP(memory[adr]) == instruction;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void resolvePending(Aaddr opener, Aaddr closer, InstClass instruction, Aaddr target) {
+    /* Instructions that need the closing address of their block are
+       temporarily given the address of the opening instruction until
+       the closer is found */
+    for (Aaddr adr = opener+1; adr < closer; adr++)
+        if (branchTargets[adr] == opener && isInstruction(adr, instruction))
+            branchTargets[adr] = target;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void forgetTargets(Aaddr start, Aaddr end) {
+    for (Aaddr adr = start; adr <= end && adr < branchTargetsSize; adr++)
+        branchTargets[adr] = 0;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexStatements(Aaddr adr) {
+    Aaddr ifs[MAXNESTING];
+    int ifLevel = 0;
+    Aaddr loops[MAXNESTING];
+    int loopLevel = 0;
+    Aaddr depends[MAXNESTING];
+    Aaddr pendingExecs[MAXNESTING];
+    int dependLevel = 0;
+    Aaddr pc;
+
+    if (adr == 0) return;
+
+    for (pc = adr; pc < branchTargetsSize; pc++) {
+        if (I_CLASS(memory[pc]) != (Aword)C_STMOP)
+            continue;
+        switch (I_OP(memory[pc])) {
+        case I_RETURN:
+            if (ifLevel == 0 && loopLevel == 0 && dependLevel == 0)
+                return;
+            goto malformed;
+
+        case I_IF:
+            if (ifLevel == MAXNESTING) goto malformed;
+            ifs[ifLevel++] = pc;
+            break;
+        case I_ELSE:
+            if (ifLevel == 0 || !isInstruction(ifs[ifLevel-1], I_IF)) goto malformed;
+            branchTargets[ifs[ifLevel-1]] = pc+1;
+            ifs[ifLevel-1] = pc;
+            break;
+        case I_ENDIF:
+            if (ifLevel == 0) goto malformed;
+            branchTargets[ifs[--ifLevel]] = pc+1;
+            break;
+
+        case I_LOOP:
+            if (loopLevel == MAXNESTING) goto malformed;
+            loops[loopLevel++] = pc;
+            break;
+        case I_LOOPNEXT:
+            if (loopLevel == 0) goto malformed;
+            branchTargets[pc] = loops[loopLevel-1];
+            break;
+        case I_LOOPEND:
+            if (loopLevel == 0) goto malformed;
+            loopLevel--;
+            resolvePending(loops[loopLevel], pc, I_LOOPNEXT, pc);
+            branchTargets[loops[loopLevel]] = pc;
+            branchTargets[pc] = loops[loopLevel];
+            break;
+
+        case I_DEPEND:
+            if (dependLevel == MAXNESTING) goto malformed;
+            pendingExecs[dependLevel] = 0;
+            depends[dependLevel++] = pc;
+            break;
+        case I_DEPEXEC:
+            if (dependLevel == 0 || pendingExecs[dependLevel-1] != 0) goto malformed;
+            pendingExecs[dependLevel-1] = pc;
+            break;
+        case I_DEPCASE:
+        case I_DEPELSE:
+            if (dependLevel == 0) goto malformed;
+            if (pendingExecs[dependLevel-1] != 0)
+                branchTargets[pendingExecs[dependLevel-1]] = pc+1;
+            pendingExecs[dependLevel-1] = 0;
+            branchTargets[pc] = depends[dependLevel-1];
+            break;
+        case I_ENDDEP:
+            if (dependLevel == 0) goto malformed;
+            dependLevel--;
+            if (pendingExecs[dependLevel] != 0)
+                branchTargets[pendingExecs[dependLevel]] = pc;
+            resolvePending(depends[dependLevel], pc, I_DEPCASE, pc);
+            resolvePending(depends[dependLevel], pc, I_DEPELSE, pc);
+            break;
+        }
+    }
+
+ malformed:
+    /* Leave this code to the scanning in the interpreter */
+    forgetTargets(adr, pc);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexChecks(Aaddr adr) {
+    CheckEntry *e = (CheckEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexStatements(e->exp);
+        indexStatements(e->stms);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexAlternatives(Aaddr adr) {
+    AltEntry *e = (AltEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexChecks(e->checks);
+        indexStatements(e->action);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexVerbs(Aaddr adr) {
+    VerbEntry *e = (VerbEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++)
+        indexAlternatives(e->alts);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexExits(Aaddr adr) {
+    ExitEntry *e = (ExitEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexChecks(e->checks);
+        indexStatements(e->action);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexClasses(Aaddr adr) {
+    ClassEntry *e = (ClassEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexStatements(e->name);
+        indexStatements(e->initialize);
+        indexChecks(e->descriptionChecks);
+        indexStatements(e->description);
+        indexStatements(e->entered);
+        indexStatements(e->definite.address);
+        indexStatements(e->indefinite.address);
+        indexStatements(e->negative.address);
+        indexStatements(e->mentioned);
+        indexVerbs(e->verbs);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexInstances(Aaddr adr) {
+    InstanceEntry *e = (InstanceEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexStatements(e->name);
+        indexStatements(e->initialize);
+        indexStatements(e->definite.address);
+        indexStatements(e->indefinite.address);
+        indexStatements(e->negative.address);
+        indexStatements(e->mentioned);
+        indexChecks(e->checks);
+        indexStatements(e->description);
+        indexVerbs(e->verbs);
+        indexStatements(e->entered);
+        indexExits(e->exits);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexScripts(Aaddr adr) {
+    ScriptEntry *e = (ScriptEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexStatements(e->description);
+        if (e->steps != 0) {
+            StepEntry *step;
+            for (step = (StepEntry *) pointerTo(e->steps); !isEndOfArray(step); step++) {
+                indexStatements(step->after);
+                indexStatements(step->exp);
+                indexStatements(step->stms);
+            }
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexContainers(Aaddr adr) {
+    ContainerEntry *e = (ContainerEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        if (e->limits != 0) {
+            LimitEntry *limit;
+            for (limit = (LimitEntry *) pointerTo(e->limits); !isEndOfArray(limit); limit++)
+                indexStatements(limit->stms);
+        }
+        indexStatements(e->header);
+        indexStatements(e->empty);
+        indexChecks(e->extractChecks);
+        indexStatements(e->extractStatements);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexEvents(Aaddr adr) {
+    EventEntry *e = (EventEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++)
+        indexStatements(e->code);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexRules(Aaddr adr) {
+    RuleEntry *e = (RuleEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        indexStatements(e->exp);
+        indexStatements(e->stms);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexMessages(Aaddr adr) {
+    MessageEntry *e = (MessageEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++)
+        indexStatements(e->stms);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexElements(Aaddr adr) {
+    ElementEntry *e = (ElementEntry *) pointerTo(adr);
+
+    if (adr == 0) return;
+
+    for (; !isEndOfArray(e); e++) {
+        if (e->code == EOS) {
+            RestrictionEntry *restriction;
+            if (e->next != 0)
+                for (restriction = (RestrictionEntry *) pointerTo(e->next); !isEndOfArray(restriction); restriction++)
+                    indexStatements(restriction->stms);
+        } else
+            indexElements(e->next);
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexSyntaxes(Aaddr adr) {
+    if (adr == 0) return;
+
+    if (isPreBeta2(header->version)) {
+        SyntaxEntryPreBeta2 *e;
+        for (e = (SyntaxEntryPreBeta2 *) pointerTo(adr); !isEndOfArray(e); e++)
+            indexElements(e->elms);
+    } else {
+        SyntaxEntry *e;
+        for (e = (SyntaxEntry *) pointerTo(adr); !isEndOfArray(e); e++)
+            indexElements(e->elms);
+    }
+}
+
+
+/*======================================================================*/
+void indexBranchTargets(void) {
+    freeBranchTargets();
+
+    branchTargetsSize = memTop;
+    branchTargets = allocate((branchTargetsSize+1)*sizeof(Aaddr));
+
+    indexSyntaxes(header->syntaxTableAddress);
+    indexVerbs(header->verbTableAddress);
+    indexClasses(header->classTableAddress);
+    indexInstances(header->instanceTableAddress);
+    indexScripts(header->scriptTableAddress);
+    indexContainers(header->containerTableAddress);
+    indexEvents(header->eventTableAddress);
+    indexRules(header->ruleTableAddress);
+    indexStatements(header->prompt);
+    indexStatements(header->start);
+    indexMessages(header->messageTableAddress);
+}
+
+
+/*======================================================================*/
+void freeBranchTargets(void) {
+    if (branchTargets != NULL)
+        deallocate(branchTargets);
+    branchTargets = NULL;
+    branchTargetsSize = 0;
+}
+
+
+/*======================================================================*/
+Aaddr branchTarget(Aaddr instructionAddress) {
+    if (instructionAddress >= branchTargetsSize)
+        return 0;
+    return branchTargets[instructionAddress];
+}
@@ -0,0 +1,32 @@
+#ifndef BRANCHES_H_
+#define BRANCHES_H_
+/*----------------------------------------------------------------------*\
+
+  branches
+
+  Precomputed targets for the control flow instructions (IF, ELSE,
+  LOOP, LOOPNEXT, LOOPEND, DEPEXEC, DEPCASE and DEPELSE) so that the
+  interpreter does not have to scan the code for the matching
+  instruction every time it jumps.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern void indexBranchTargets(void);
+extern void freeBranchTargets(void);
+extern Aaddr branchTarget(Aaddr instructionAddress);
+
+#endif /* BRANCHES_H_ */
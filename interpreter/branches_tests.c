@@ -0,0 +1,126 @@
+#include <cgreen/cgreen.h>
+#include <cgreen/mocks.h>
+
+#include "branches.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "instance.mock"
+#include "compatibility.mock"
+
+
+static Aaddr code;
+
+static void given_code(Aword instructions[], int length) {
+    int headerSize = sizeof(ACodeHeader)/sizeof(Aword);
+
+    memory = allocate((headerSize+length+1)*sizeof(Aword));
+    header = (ACodeHeader *)memory;
+    memTop = headerSize+length;
+
+    code = headerSize;
+    memcpy(&memory[code], instructions, length*sizeof(Aword));
+    header->start = code;
+}
+
+
+Describe(Branches);
+BeforeEach(Branches) {}
+AfterEach(Branches) {
+    freeBranchTargets();
+    free(memory);
+    memory = NULL;
+}
+
+
+Ensure(Branches, returns_no_target_when_nothing_is_indexed) {
+    assert_that(branchTarget(17), is_equal_to(0));
+}
+
+Ensure(Branches, finds_else_and_endif_for_if) {
+    Aword instructions[] = {
+        CONSTANT(1), INSTRUCTION(I_IF),
+        CONSTANT(2), INSTRUCTION(I_ELSE),
+        CONSTANT(3), INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    indexBranchTargets();
+
+    assert_that(branchTarget(code+1), is_equal_to(code+4));
+    assert_that(branchTarget(code+3), is_equal_to(code+6));
+}
+
+Ensure(Branches, skips_nested_if_when_finding_endif) {
+    Aword instructions[] = {
+        CONSTANT(1), INSTRUCTION(I_IF),
+        CONSTANT(1), INSTRUCTION(I_IF), INSTRUCTION(I_ELSE), INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    indexBranchTargets();
+
+    assert_that(branchTarget(code+1), is_equal_to(code+7));
+    assert_that(branchTarget(code+3), is_equal_to(code+5));
+    assert_that(branchTarget(code+4), is_equal_to(code+6));
+}
+
+Ensure(Branches, pairs_loop_and_loopend_and_resolves_loopnext) {
+    Aword instructions[] = {
+        INSTRUCTION(I_LOOP),
+        CONSTANT(1), INSTRUCTION(I_IF), INSTRUCTION(I_LOOPNEXT), INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_LOOP), INSTRUCTION(I_LOOPNEXT), INSTRUCTION(I_LOOPEND),
+        INSTRUCTION(I_LOOPNEXT),
+        INSTRUCTION(I_LOOPEND),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    indexBranchTargets();
+
+    assert_that(branchTarget(code+0), is_equal_to(code+9));
+    assert_that(branchTarget(code+9), is_equal_to(code+0));
+    assert_that(branchTarget(code+3), is_equal_to(code+9));
+    assert_that(branchTarget(code+5), is_equal_to(code+7));
+    assert_that(branchTarget(code+6), is_equal_to(code+7));
+    assert_that(branchTarget(code+7), is_equal_to(code+5));
+    assert_that(branchTarget(code+8), is_equal_to(code+9));
+}
+
+Ensure(Branches, finds_next_case_and_end_of_depending) {
+    Aword instructions[] = {
+        INSTRUCTION(I_DEPEND), CONSTANT(1),
+        INSTRUCTION(I_DUP), CONSTANT(1), INSTRUCTION(I_EQ), INSTRUCTION(I_DEPEXEC),
+        CONSTANT(2), INSTRUCTION(I_POP),
+        INSTRUCTION(I_DEPCASE),
+        INSTRUCTION(I_DUP), CONSTANT(3), INSTRUCTION(I_EQ), INSTRUCTION(I_DEPEXEC),
+        INSTRUCTION(I_DEPELSE),
+        INSTRUCTION(I_ENDDEP),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    indexBranchTargets();
+
+    assert_that(branchTarget(code+5), is_equal_to(code+9));
+    assert_that(branchTarget(code+8), is_equal_to(code+14));
+    assert_that(branchTarget(code+12), is_equal_to(code+14));
+    assert_that(branchTarget(code+13), is_equal_to(code+14));
+}
+
+Ensure(Branches, leaves_unbalanced_code_to_be_scanned) {
+    Aword instructions[] = {
+        CONSTANT(1), INSTRUCTION(I_IF),
+        CONSTANT(1), INSTRUCTION(I_IF), INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    indexBranchTargets();
+
+    assert_that(branchTarget(code+1), is_equal_to(0));
+    assert_that(branchTarget(code+3), is_equal_to(0));
+}
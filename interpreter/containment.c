@@ -0,0 +1,145 @@
+/*----------------------------------------------------------------------*\
+
+  containment
+
+  Index of the instances directly at or in each instance.
+
+  For every instance we keep the first of the instances having it as
+  their location, and for every instance the next one having the same
+  location. The lists are kept sorted on instance number so that
+  walking them gives the same order as looking at every instance from
+  1 to instanceMax, which is what listings and descriptions expect.
+
+  All changes of location must go through setLocationOf(), bulk
+  changes to admin[] (initialisation, restore and undo) must be
+  followed by indexContainment(). Both make the instances forget the
+  locations that might have changed, for setLocationOf() that is the
+  moved instance and everything in or at it.
+
+\*----------------------------------------------------------------------*/
+#include "containment.h"
+
+/* IMPORTS */
+#include "memory.h"
+#include "instance.h"
+
+
+/* PRIVATE DATA */
+static int *firstChild = NULL;  /* First instance located at/in an instance */
+static int *nextSibling = NULL; /* Next instance with the same location */
+static int indexedMax = 0;      /* Highest instance in the index */
+
+
+/*----------------------------------------------------------------------*/
+static bool isIndexed(int instance) {
+    return instance > 0 && instance <= indexedMax;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void removeChild(int instance, int parent) {
+    int *link;
+
+    if (!isIndexed(parent)) return;
+
+    for (link = &firstChild[parent]; *link != 0; link = &nextSibling[*link])
+        if (*link == instance) {
+            *link = nextSibling[instance];
+            nextSibling[instance] = 0;
+            return;
+        }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void insertChild(int instance, int parent) {
+    int *link;
+
+    if (!isIndexed(parent)) return;
+
+    for (link = &firstChild[parent]; *link != 0 && *link < instance; link = &nextSibling[*link])
+        ;
+    nextSibling[instance] = *link;
+    *link = instance;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void forgetLocationsWithin(int instance) {
+    int child;
+
+    forgetLocationOf(instance);
+    for (child = firstChild[instance]; child != 0; child = nextSibling[child])
+        forgetLocationsWithin(child);
+}
+
+
+/*======================================================================*/
+void indexContainment(void) {
+    int instance;
+
+    freeContainment();
+    forgetAllLocations();
+
+    indexedMax = header->instanceMax;
+    firstChild = allocate((indexedMax+1)*sizeof(int));
+    nextSibling = allocate((indexedMax+1)*sizeof(int));
+
+    /* Backwards, so that inserting first keeps the lists sorted */
+    for (instance = indexedMax; instance > 0; instance--) {
+        int parent = admin.location[instance];
+        if (isIndexed(parent)) {
+            nextSibling[instance] = firstChild[parent];
+            firstChild[parent] = instance;
+        }
+    }
+}
+
+
+/*======================================================================*/
+void freeContainment(void) {
+    if (firstChild != NULL)
+        deallocate(firstChild);
+    if (nextSibling != NULL)
+        deallocate(nextSibling);
+    firstChild = NULL;
+    nextSibling = NULL;
+    indexedMax = 0;
+}
+
+
+/*======================================================================*/
+void setLocationOf(int instance, int location) {
+    if (firstChild != NULL && isIndexed(instance)) {
+        removeChild(instance, admin.location[instance]);
+        insertChild(instance, location);
+        forgetLocationsWithin(instance);
+    } else
+        forgetAllLocations();
+    admin.location[instance] = location;
+}
+
+
+/*======================================================================*/
+int firstContained(int parent) {
+    if (firstChild == NULL)
+        indexContainment();
+    if (!isIndexed(parent))
+        return 0;
+    return firstChild[parent];
+}
+
+
+/*======================================================================*/
+int nextContained(int parent, int previous) {
+    int instance;
+
+    if (isIndexed(previous) && admin.location[previous] == parent)
+        return nextSibling[previous];
+
+    /* The previous instance has been moved while we were looking at
+       it, so find the one that now follows its position */
+    for (instance = firstContained(parent); instance != 0 && instance < previous; instance = nextSibling[instance])
+        ;
+    return instance;
+}
@@ -0,0 +1,34 @@
+#ifndef CONTAINMENT_H_
+#define CONTAINMENT_H_
+/*----------------------------------------------------------------------*\
+
+  containment
+
+  Index from each instance to the instances directly at or in it
+  (i.e. having it as their admin[].location), kept in instance number
+  order, so that listing contents does not need to look at every
+  instance in the game.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern void indexContainment(void);
+extern void freeContainment(void);
+extern void setLocationOf(int instance, int location);
+extern int firstContained(int parent);
+extern int nextContained(int parent, int previous);
+
+#endif /* CONTAINMENT_H_ */
@@ -0,0 +1,132 @@
+#include <cgreen/cgreen.h>
+#include <cgreen/mocks.h>
+
+#include "containment.h"
+
+#include "memory.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "instance.mock"
+
+
+static void given_instances_at(Aint locations[], int count) {
+    header->instanceMax = count;
+    admin.location = allocate((count+1)*sizeof(Aint));
+    for (int i = 1; i <= count; i++)
+        admin.location[i] = locations[i-1];
+    indexContainment();
+}
+
+static void expect_locations_to_be_forgotten(void) {
+    always_expect(forgetLocationOf);
+}
+
+static int contents(int parent, int found[]) {
+    int count = 0;
+    for (int i = firstContained(parent); i != 0; i = nextContained(parent, i))
+        found[count++] = i;
+    return count;
+}
+
+
+Describe(Containment);
+BeforeEach(Containment) {
+    always_expect(forgetAllLocations);
+}
+AfterEach(Containment) {
+    freeContainment();
+    free(admin.location);
+    admin.location = NULL;
+}
+
+
+Ensure(Containment, lists_contents_in_instance_order) {
+    Aint locations[] = {0, 1, 1, 2, 1, 0};
+    int found[6];
+    given_instances_at(locations, ASIZE(locations));
+
+    assert_that(contents(1, found), is_equal_to(3));
+    assert_that(found[0], is_equal_to(2));
+    assert_that(found[1], is_equal_to(3));
+    assert_that(found[2], is_equal_to(5));
+    assert_that(contents(2, found), is_equal_to(1));
+    assert_that(found[0], is_equal_to(4));
+    assert_that(contents(6, found), is_equal_to(0));
+}
+
+Ensure(Containment, keeps_instance_order_when_locating) {
+    Aint locations[] = {0, 0, 1, 2, 1};
+    int found[5];
+    given_instances_at(locations, ASIZE(locations));
+    expect_locations_to_be_forgotten();
+
+    setLocationOf(4, 1);
+    setLocationOf(2, 1);
+
+    assert_that(admin.location[4], is_equal_to(1));
+    assert_that(contents(1, found), is_equal_to(4));
+    assert_that(found[0], is_equal_to(2));
+    assert_that(found[1], is_equal_to(3));
+    assert_that(found[2], is_equal_to(4));
+    assert_that(found[3], is_equal_to(5));
+    assert_that(contents(2, found), is_equal_to(0));
+}
+
+Ensure(Containment, can_locate_to_nowhere_and_back) {
+    Aint locations[] = {0, 1, 1};
+    int found[3];
+    given_instances_at(locations, ASIZE(locations));
+    expect_locations_to_be_forgotten();
+
+    setLocationOf(2, 0);
+    assert_that(contents(1, found), is_equal_to(1));
+    assert_that(found[0], is_equal_to(3));
+
+    setLocationOf(2, 1);
+    assert_that(contents(1, found), is_equal_to(2));
+    assert_that(found[0], is_equal_to(2));
+}
+
+Ensure(Containment, continues_after_an_instance_moved_while_walking) {
+    Aint locations[] = {0, 1, 1, 1, 1};
+    int i;
+    given_instances_at(locations, ASIZE(locations));
+    expect_locations_to_be_forgotten();
+
+    i = firstContained(1);
+    i = nextContained(1, i);
+    assert_that(i, is_equal_to(3));
+
+    setLocationOf(3, 0);
+    setLocationOf(4, 0);
+
+    assert_that(nextContained(1, i), is_equal_to(5));
+}
+
+Ensure(Containment, reflects_bulk_changes_after_reindexing) {
+    Aint locations[] = {0, 1, 1};
+    int found[3];
+    given_instances_at(locations, ASIZE(locations));
+
+    admin.location[2] = 3;
+    indexContainment();
+
+    assert_that(contents(1, found), is_equal_to(1));
+    assert_that(found[0], is_equal_to(3));
+    assert_that(contents(3, found), is_equal_to(1));
+    assert_that(found[0], is_equal_to(2));
+}
+
+Ensure(Containment, forgets_locations_of_moved_instance_and_everything_in_it) {
+    Aint locations[] = {0, 0, 1, 3, 4, 1};
+    given_instances_at(locations, ASIZE(locations));
+
+    expect(forgetLocationOf, when(instance, is_equal_to(3)));
+    expect(forgetLocationOf, when(instance, is_equal_to(4)));
+    expect(forgetLocationOf, when(instance, is_equal_to(5)));
+
+    setLocationOf(3, 2);
+
+    assert_that(admin.location[3], is_equal_to(2));
+}
@@ -13,30 +13,37 @@
 #define WINICONV_CONST
 #include <iconv.h>
 
-/* Outgoing - will always return an alloc'd string that needs to be freed */
-char *ensureExternalEncoding(char input[]) {
-    if (encodingOption == ENCODING_UTF) {
-        iconv_t cd = iconv_open("UTF-8", "ISO_8859-1");
-        if (cd == (iconv_t) -1)
-            syserr("iconv_open() failed!");
+/* Outgoing - converts length characters into output, which must have
+   room for MAX_EXTERNAL_CHARACTER_LENGTH bytes per character, and
+   returns the number of bytes. Each ISO8859-1 character is the code
+   point with the same number, so UTF-8 needs no lookup. */
+int toExternalEncoding(char output[], char input[], int length) {
+    unsigned char *in_p = (unsigned char *)input;
+    char *out_p = output;
+    int i;
+
+    if (encodingOption != ENCODING_UTF) {
+        memcpy(output, input, length);
+        return length;
+    }
+    for (i = 0; i < length; i++)
+        if (in_p[i] < 0x80)
+            *out_p++ = in_p[i];
+        else {
+            *out_p++ = 0xC0 | (in_p[i] >> 6);
+            *out_p++ = 0x80 | (in_p[i] & 0x3F);
+        }
+    return out_p - output;
+}
 
-        /* UTF-8 might be longer than ISO8859-1 encoding so double */
-        char *in_p = input;
-        size_t in_left = strlen(input);
-        size_t out_left = strlen(input)*2;
-        char *converted = (char *)malloc(out_left+1);
-        char *out_p = converted;
 
-        if (iconv(cd, &in_p, &in_left, &out_p, &out_left) == (size_t) -1) {
-            /* Internal code (ISO8859-1) to UTF should never fail */
-            syserr("Conversion of command output to UTF-8 failed");
-        }
-        *out_p = '\0';
+/* Outgoing - will always return an alloc'd string that needs to be freed */
+char *ensureExternalEncoding(char input[]) {
+    int length = strlen(input);
+    char *converted = (char *)malloc(length*MAX_EXTERNAL_CHARACTER_LENGTH+1);
 
-        iconv_close(cd);
-        return converted;
-    } else
-        return strdup(input);
+    converted[toExternalEncoding(converted, input, length)] = '\0';
+    return converted;
 }
 
 
@@ -71,6 +78,11 @@ char *ensureInternalEncoding(char input[]) {
 
 /* For Gargoyle/GARGLK we just return the original string to avoid extra dependency on iconv */
 
+int toExternalEncoding(char output[], char input[], int length) {
+    memcpy(output, input, length);
+    return length;
+}
+
 char *ensureExternalEncoding(char input[]) {
     return strdup(input);
 }
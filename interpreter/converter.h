@@ -8,9 +8,13 @@
 
 \*----------------------------------------------------------------------*/
 
+/* Constants: */
+#define MAX_EXTERNAL_CHARACTER_LENGTH 2 /* Bytes for one character in UTF-8 */
+
 /* Data: */
 
 /* Functions: */
+extern int toExternalEncoding(char output[], char input[], int length);
 extern char *ensureExternalEncoding(char input[]);
 extern char *ensureInternalEncoding(char string[]);
 
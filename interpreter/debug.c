@@ -34,6 +34,8 @@
 #include "class.h"
 #include "event.h"
 #include "exe.h"
+#include "textcache.h"
+#include "replay.h"
 
 #ifdef HAVE_GLK
 #include "glk.h"
@@ -113,21 +115,21 @@ static void sayInstanceNumberAndName(int ins) {
 
 /*----------------------------------------------------------------------*/
 static void sayLocationOfInstance(int ins, char *prefix) {
-    if (admin[ins].location == 0)
+    if (admin.location[ins] == 0)
         return;
     else {
         if (prefix) output(prefix);
-        if (isALocation(admin[ins].location)) {
+        if (isALocation(admin.location[ins])) {
             output("at");
-            sayInstanceNumberAndName(admin[ins].location);
-            sayLocationOfInstance(admin[ins].location, prefix);
-        } else if (isAContainer(admin[ins].location)) {
-            if (isAObject(admin[ins].location))
+            sayInstanceNumberAndName(admin.location[ins]);
+            sayLocationOfInstance(admin.location[ins], prefix);
+        } else if (isAContainer(admin.location[ins])) {
+            if (isAObject(admin.location[ins]))
                 output("in");
-            else if (isAActor(admin[ins].location))
+            else if (isAActor(admin.location[ins]))
                 output("carried by");
-            sayInstanceNumberAndName(admin[ins].location);
-            sayLocationOfInstance(admin[ins].location, prefix);
+            sayInstanceNumberAndName(admin.location[ins]);
+            sayLocationOfInstance(admin.location[ins], prefix);
         } else
             output("Illegal location!");
     }
@@ -180,7 +182,7 @@ static void showInstance(int ins)
         output(str);
     }
 
-    if (!isA(ins, header->locationClassId) || (isA(ins, header->locationClassId) && admin[ins].location != 0)) {
+    if (!isA(ins, header->locationClassId) || (isA(ins, header->locationClassId) && admin.location[ins] != 0)) {
         sprintf(str, "$iLocation:");
         output(str);
         needSpace = true;
@@ -188,16 +190,16 @@ static void showInstance(int ins)
     }
 
     output("$iAttributes:");
-    showAttributes(admin[ins].attributes);
+    showAttributes(admin.attributes[ins]);
 
     if (instances[ins].container)
         showContents(ins);
 
     if (isA(ins, header->actorClassId)) {
-        if (admin[ins].script == 0)
+        if (admin.script[ins] == 0)
             output("$iIs idle");
         else {
-            sprintf(str, "$iExecuting script: %d, Step: %d", admin[ins].script, admin[ins].step);
+            sprintf(str, "$iExecuting script: %d, Step: %d", admin.script[ins], admin.step[ins]);
             output(str);
         }
     }
@@ -388,7 +390,7 @@ static void showLocation(int loc)
     output(str);
 
     output("$iAttributes =");
-    showAttributes(admin[loc].attributes);
+    showAttributes(admin.attributes[loc]);
 }
 
 
@@ -426,6 +428,7 @@ static void showEvents(void)
     char str[80];
     bool scheduled;
 
+    exportEventQueue();
     output("Events:");
     for (event = 1; event <= header->eventMax; event++) {
         sprintf(str, "$i%d [%s]:", event, (char *)pointerTo(events[event].id));
@@ -444,6 +447,17 @@ static void showEvents(void)
 }
 
 
+/*----------------------------------------------------------------------*/
+static void showStatistics(void)
+{
+    char str[200];
+
+    sprintf(str, "Text cache: %d hits, %d misses, %d texts using %ld bytes (budget %d kilobytes)",
+            textCacheHits, textCacheMisses, cachedTextCount(), cachedTextSize(), textCacheOption);
+    output(str);
+}
+
+
 /*======================================================================*/
 char *sourceFileName(int fileNumber) {
     SourceFileEntry *entries = pointerTo(header->sourceFileTable);
@@ -669,6 +683,7 @@ void restoreInfo(void)
 #define TRACE_INSTRUCTION_COMMAND 'i'
 #define TRACE_PUSH_COMMAND 'p'
 #define TRACE_STACK_COMMAND 't'
+#define STATISTICS_COMMAND 'Z'
 
 typedef struct DebugParseEntry {
     char *command;
@@ -684,6 +699,7 @@ static DebugParseEntry commandEntries[] = {
     {"delete", "[[file:]n]", DELETE_COMMAND, "delete breakpoint at source line [n] (optionally in [file])"},
     {"files", "", FILES_COMMAND, "list source files"},
     {"events", "", EVENTS_COMMAND, "list events"},
+    {"statistics", "", STATISTICS_COMMAND, "show text cache statistics"},
     {"classes", "", CLASSES_COMMAND, "list class hierarchy"},
     {"instances", "[n]", INSTANCES_COMMAND, "list instance(s), all, wildcard, number or name"},
     {"objects", "[n]", OBJECTS_COMMAND, "list instance(s) that are objects"},
@@ -778,6 +794,8 @@ static char parseDebugCommand(char *command) {
 static void readCommand(char buf[]) {
     char c;
 
+    /* The command log has no debugger commands, so let the player */
+    endReplay();
     capitalize = false;
     if (anyOutput) newline();
     do {
@@ -1073,6 +1091,7 @@ void debug(bool calledFromBreakpoint, int line, int fileNumber)
         case OBJECTS_COMMAND: handleObjectsCommand(); break;
         case QUIT_COMMAND: terminate(0); break;
         case SECTION_TRACE_COMMAND: toggleSectionTrace(); break;
+        case STATISTICS_COMMAND: showStatistics(); break;
         default: output("Unknown ADBG command. ? for help."); break;
         }
     }
@@ -4,6 +4,9 @@
 
   Arithmetic decoding module in Arun
 
+  Also the source of the text data, which is read into memory at once
+  instead of character by character from the text file.
+
 \*----------------------------------------------------------------------*/
 #include "decode.h"
 
@@ -12,6 +15,7 @@
 #include "syserr.h"
 #include "exe.h"
 #include "memory.h"
+#include "textcache.h"
 
 
 /* PUBLIC DATA */
@@ -19,29 +23,123 @@ Aword *freq;            /* Cumulative character frequencies */
 
 
 /* PRIVATE DATA */
-/* Bit output */
-static int decodeBuffer;	/* Bits to be input */
-static int bitsToGo;		/* Bits still in buffer */
-static int garbageBits;		/* Bits past EOF */
+/* Text input */
+static unsigned char *text = NULL; /* Contents of the text file */
+static long textSize = 0;
+static long textPos = 0;        /* Next character to read */
 
 
-static int inputBit(void)
+/*======================================================================*/
+void loadText(FILE *file)
 {
-  int bit;
-
-  if (!bitsToGo) {		/* More bits available ? */
-    decodeBuffer = getc(textFile); /* No, so get more */
-    if (decodeBuffer == EOF) {
-      garbageBits++;
-      if (garbageBits > VALUEBITS-2)
-	syserr("Error in encoded data file.");
-    } else
-      bitsToGo = 8;		/* Another Char, 8 new bits */
+  if (text != NULL)
+    deallocate(text);
+  clearTextCache();
+
+  fseek(file, 0, SEEK_END);
+  textSize = ftell(file);
+  text = allocate(textSize+1);
+  fseek(file, 0, SEEK_SET);
+  if (fread(text, 1, textSize, file) != (size_t)textSize)
+    syserr("Could not read text data.");
+}
+
+
+/*======================================================================*/
+void positionText(long position)
+{
+  if (text == NULL)
+    loadText(textFile);
+  textPos = position;
+}
+
+
+/*======================================================================*/
+long textPosition(void)
+{
+  return textPos;
+}
+
+
+/*======================================================================*/
+int readTextChar(void)
+{
+  if (textPos >= textSize)
+    return EOF;
+  return text[textPos++];
+}
+
+
+/* Bit input */
+static Aword bits;              /* Bits to be input, first in the highest */
+static int bitsToGo;            /* Bits still in buffer */
+static int garbageBytes;        /* Bytes past EOF */
+
+static unsigned char reversed[256]; /* Bits of a byte in reverse order */
+static bool reversedInitialized = false;
+
+
+/*----------------------------------------------------------------------*/
+static void initReversed(void)
+{
+  int byte, bit;
+
+  for (byte = 0; byte < 256; byte++) {
+    reversed[byte] = 0;
+    for (bit = 0; bit < 8; bit++)
+      if (byte & (1<<bit))
+        reversed[byte] |= 0x80>>bit;
+  }
+  reversedInitialized = true;
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Get the next 'count' (at most VALUEBITS) bits, the first in the
+   highest position. Bytes are packed starting with the lowest bit. */
+static int inputBits(int count)
+{
+  int result;
+
+  while (bitsToGo < count) {
+    int byte = readTextChar();
+    if (byte == EOF) {
+      /* Past the end all bits are ones, as for the EOF from getc() */
+      byte = 0xff;
+      if (++garbageBytes > VALUEBITS/8+1)
+        syserr("Error in encoded data file.");
+    }
+    bits = (bits<<8) | reversed[byte];
+    bitsToGo += 8;
   }
-  bit = decodeBuffer&1;		/* Get next bit */
-  decodeBuffer = decodeBuffer>>1; /* and remove it */
-  bitsToGo--;
-  return bit;
+  bitsToGo -= count;
+  result = (bits>>bitsToGo) & ((1<<count)-1);
+  bits &= (1<<bitsToGo)-1;
+  return result;
+}
+
+
+/* Symbol lookup */
+static unsigned short *symbolFor = NULL; /* Symbol for each scaled target */
+static Aword *symbolsFrom = NULL;        /* The frequency table they are for */
+
+
+/*----------------------------------------------------------------------*/
+/* Build a table giving the symbol to decode directly from the scaled
+   target, the first symbol with a cumulative frequency not above it */
+static void buildSymbolTable(void)
+{
+  int symbol;
+  Aword f;
+
+  if (symbolFor != NULL)
+    deallocate(symbolFor);
+  symbolFor = allocate(freq[0]*sizeof(unsigned short));
+
+  for (symbol = 1; freq[symbol-1] != 0; symbol++)
+    for (f = freq[symbol]; f < freq[symbol-1]; f++)
+      symbolFor[f] = symbol;
+  symbolsFrom = freq;
 }
 
 
@@ -51,112 +149,74 @@ static CodeValue value;			/* Currently seen code value */
 static CodeValue low, high;		/* Current code region */
 
 
+/*======================================================================*/
 void startDecoding(void)
 {
-  int i;
+  if (!reversedInitialized)
+    initReversed();
+  if (symbolsFrom != freq)
+    buildSymbolTable();
 
+  bits = 0;
   bitsToGo = 0;
-  garbageBits = 0;
+  garbageBytes = 0;
 
-  value = 0;
-  for (i = 0; i < VALUEBITS; i++)
-    value = 2*value + inputBit();
+  value = inputBits(VALUEBITS);
   low = 0;
   high = TOPVALUE;
 }
 
 
+/*----------------------------------------------------------------------*/
+/* Number of leading bits that are the same in two code values */
+static int equalLeadingBits(CodeValue a, CodeValue b)
+{
+  CodeValue difference = (a^b) & TOPVALUE;
+  int count = 0;
+
+  while (count < VALUEBITS && (difference & HALF) == 0) {
+    difference <<= 1;
+    count++;
+  }
+  return count;
+}
+
+
+/*======================================================================*/
 int decodeChar(void)
 {
   long range;
   int f;
   int symbol;
+  int shift;
 
   range = (long)(high-low) + 1;
   f = (((long)(value-low)+1)*freq[0]-1)/range;
 
-  /* Find the symbol */
-  for (symbol = 1; freq[symbol] > f; symbol++);
+  symbol = symbolFor[f];
 
   high = low + range*freq[symbol-1]/freq[0]-1;
   low = low + range*freq[symbol]/freq[0];
 
   for (;;) {
-    if (high < HALF)
-      ;
-    else if (low >= HALF) {
-      value = value - HALF;
-      low = low - HALF;
-      high = high - HALF;
+    shift = equalLeadingBits(low, high);
+    if (shift > 0) {
+      /* Both in the same half, possibly several times over, so
+         scale up the range as many bits at once */
+      low = (low<<shift) & TOPVALUE;
+      high = ((high<<shift) | ((1<<shift)-1)) & TOPVALUE;
+      value = ((value<<shift) & TOPVALUE) | inputBits(shift);
     } else if (low >= ONEQUARTER && high < THREEQUARTER) {
       value = value - ONEQUARTER;
       low = low - ONEQUARTER;
       high = high - ONEQUARTER;
+
+      /* Scale up the range */
+      low = 2*low;
+      high = 2*high+1;
+      value = 2*value + inputBits(1);
     } else
       break;
-
-    /* Scale up the range */
-    low = 2*low;
-    high = 2*high+1;
-    value = 2*value + inputBit();
   }
   return symbol-1;
 }
-
-
-
-/* Structure for saved decode info */
-typedef struct DecodeInfo {
-  long fpos;
-  int buffer;
-  int bits;
-  CodeValue value;
-  CodeValue high;
-  CodeValue low;
-} DecodeInfo;
-
-
-/*======================================================================
-
-  pushDecode()
-
-  Save so much info about the decoding process so it is possible to
-  restore and continue later.
-
- */
-void *pushDecode(void)
-{
-  DecodeInfo *info;
-
-  info = (DecodeInfo *) allocate(sizeof(DecodeInfo));
-  info->fpos = ftell(textFile);
-  info->buffer = decodeBuffer;
-  info->bits = bitsToGo;
-  info->value = value;
-  info->high = high;
-  info->low = low;
-  return(info);
-}
-
-
-/*======================================================================
-
-  popDecode()
-
-  Restore enough info about the decoding process so it is possible to
-  continue after having decoded something else.
-
- */
-void popDecode(void *i)
-{
-  DecodeInfo *info = (DecodeInfo *) i;
-
-  fseek(textFile, info->fpos, 0);
-  decodeBuffer = info->buffer;
-  bitsToGo = info->bits;
-  value = info->value;
-  high = info->high;
-  low = info->low;
-
-  free(info);
-}
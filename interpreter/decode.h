@@ -9,6 +9,7 @@
 \*----------------------------------------------------------------------*/
 
 /* IMPORTS */
+#include <stdio.h>
 #include "types.h"
 
 /* TYPES */
@@ -18,10 +19,13 @@ extern Aword *freq;     /* Cumulated character frequencies for text decoding */
 
 /* FUNCTIONS */
 
+extern void loadText(FILE *file);
+extern void positionText(long position);
+extern long textPosition(void);
+extern int readTextChar(void);
+
 extern void startDecoding(void);
 extern int decodeChar(void);
-extern void *pushDecode(void);
-extern void popDecode(void *info);
 
 #endif
 
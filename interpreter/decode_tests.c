@@ -0,0 +1,149 @@
+#include <cgreen/cgreen.h>
+
+#include "decode.h"
+
+#include "memory.h"
+
+/* Mocks */
+#include "syserr.mock"
+#include "instance.mock"
+#include "textcache.mock"
+
+FILE *textFile;
+
+
+/* An encoder working like the one in the compiler (encode.c) */
+#define NOOFSYMBOLS (EOFChar+1)
+
+static Aword *cumFreq;
+
+static int outputBuffer;
+static int outputBitsToGo;
+static CodeValue encodeLow, encodeHigh;
+static int bitsToFollow;
+
+static void outputBit(int bit) {
+    outputBuffer = outputBuffer>>1;
+    if (bit)
+        outputBuffer |= 0x80;
+    if (--outputBitsToGo == 0) {
+        putc(outputBuffer, textFile);
+        outputBitsToGo = 8;
+        outputBuffer = 0;
+    }
+}
+
+static void bitPlusFollow(int bit) {
+    outputBit(bit);
+    for (; bitsToFollow > 0; bitsToFollow--)
+        outputBit(!bit);
+}
+
+static void encodeChar(int ch) {
+    int symbol = ch + 1;
+    long range = (long)(encodeHigh-encodeLow)+1;
+
+    encodeHigh = encodeLow + range*cumFreq[symbol-1]/cumFreq[0]-1;
+    encodeLow = encodeLow + range*cumFreq[symbol]/cumFreq[0];
+    for (;;) {
+        if (encodeHigh < HALF)
+            bitPlusFollow(0);
+        else if (encodeLow >= HALF) {
+            bitPlusFollow(1);
+            encodeLow -= HALF;
+            encodeHigh -= HALF;
+        } else if (encodeLow >= ONEQUARTER && encodeHigh < THREEQUARTER) {
+            bitsToFollow++;
+            encodeLow -= ONEQUARTER;
+            encodeHigh -= ONEQUARTER;
+        } else
+            break;
+        encodeLow = 2*encodeLow;
+        encodeHigh = 2*encodeHigh+1;
+    }
+}
+
+static long encode(char *string) {
+    long fpos = ftell(textFile);
+
+    outputBitsToGo = 8;
+    outputBuffer = 0;
+    encodeLow = 0;
+    encodeHigh = TOPVALUE;
+    bitsToFollow = 0;
+    for (char *s = string; *s; s++)
+        encodeChar((unsigned char)*s);
+    encodeChar(EOFChar);
+    bitsToFollow++;
+    bitPlusFollow(encodeLow < ONEQUARTER ? 0 : 1);
+    putc(outputBuffer>>outputBitsToGo, textFile);
+    return fpos;
+}
+
+static void given_frequencies_for(char *strings[], int count) {
+    int chFreq[NOOFSYMBOLS];
+
+    for (int ch = 0; ch < NOOFSYMBOLS; ch++)
+        chFreq[ch] = 1;
+    for (int i = 0; i < count; i++)
+        for (char *s = strings[i]; *s; s++)
+            chFreq[(unsigned char)*s] += 100;
+
+    /* A new table every time, as the decoder keeps one per table */
+    cumFreq = allocate((NOOFSYMBOLS+2)*sizeof(Aword));
+    cumFreq[NOOFSYMBOLS] = 0;
+    for (int i = NOOFSYMBOLS; i; i--)
+        cumFreq[i-1] = cumFreq[i] + chFreq[i-1];
+    cumFreq[NOOFSYMBOLS+1] = EOF;
+    freq = cumFreq;
+}
+
+static char *decode(long fpos) {
+    static char buffer[1000];
+    int i = 0;
+    int ch;
+
+    positionText(fpos);
+    startDecoding();
+    while ((ch = decodeChar()) != EOFChar)
+        buffer[i++] = ch;
+    buffer[i] = '\0';
+    return buffer;
+}
+
+
+Describe(Decode);
+BeforeEach(Decode) {
+    textFile = tmpfile();
+}
+AfterEach(Decode) {
+    fclose(textFile);
+}
+
+
+Ensure(Decode, decodes_what_the_compiler_encodes) {
+    char *strings[] = {"Hello, world!", "You are in a maze of twisty little passages, all alike.",
+                       "", "\xe5\xe4\xf6 and some ISO-8859-1", "xyzzy"};
+    long fpos[5];
+
+    given_frequencies_for(strings, 5);
+    for (int i = 0; i < 5; i++)
+        fpos[i] = encode(strings[i]);
+    loadText(textFile);
+
+    for (int i = 4; i >= 0; i--)
+        assert_that(decode(fpos[i]), is_equal_to_string(strings[i]));
+}
+
+Ensure(Decode, reads_plain_text_from_any_position) {
+    fputs("plain text", textFile);
+    loadText(textFile);
+
+    positionText(6);
+    assert_that(readTextChar(), is_equal_to('t'));
+    assert_that(textPosition(), is_equal_to(7));
+    positionText(0);
+    assert_that(readTextChar(), is_equal_to('p'));
+    positionText(10);
+    assert_that(readTextChar(), is_equal_to(EOF));
+}
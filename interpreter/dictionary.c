@@ -8,6 +8,8 @@
 /* IMPORTS */
 #include "word.h"
 #include "lists.h"
+#include "memory.h"
+#include "sysdep.h"
 
 /* PUBLIC DATA */
 DictionaryEntry *dictionary;    /* Dictionary pointer */
@@ -15,6 +17,69 @@ int dictionarySize;
 int conjWord;           /* First conjunction in dictionary, for ',' */
 
 
+/* PRIVATE DATA */
+/* Index of the dictionary words hashed on their lower case letters.
+   The chains are sorted on word index so that the first word equal
+   to a string is found first, as with a search from the start. */
+static int *firstWithHash = NULL;
+static int *nextWithHash = NULL;
+static int hashMask = 0;
+
+
+/*----------------------------------------------------------------------*/
+/* Hash on the same letters as equalStrings() compares */
+static int hashOf(char *string) {
+    unsigned int hash = 0;
+    char *s;
+
+    for (s = string; *s != '\0'; s++)
+        hash = hash*31 + (unsigned char)toLower(*s);
+    return hash & hashMask;
+}
+
+
+/*======================================================================*/
+void indexDictionary(void) {
+    int buckets = 1;
+    int w;
+
+    if (firstWithHash != NULL) {
+        deallocate(firstWithHash);
+        deallocate(nextWithHash);
+    }
+
+    while (buckets < dictionarySize)
+        buckets *= 2;
+    hashMask = buckets-1;
+    firstWithHash = allocate(buckets*sizeof(int));
+    nextWithHash = allocate((dictionarySize+1)*sizeof(int));
+    for (w = 0; w < buckets; w++)
+        firstWithHash[w] = EOF;
+
+    /* Backwards, so that inserting first keeps the chains sorted */
+    for (w = dictionarySize-1; w >= 0; w--) {
+        int hash = hashOf((char *) pointerTo(dictionary[w].string));
+        nextWithHash[w] = firstWithHash[hash];
+        firstWithHash[hash] = w;
+    }
+}
+
+
+/*======================================================================*/
+/* Find the first dictionary word equal to a string ignoring case */
+int findWord(char *string) {
+    int w;
+
+    if (firstWithHash == NULL)
+        indexDictionary();
+
+    for (w = firstWithHash[hashOf(string)]; w != EOF; w = nextWithHash[w])
+        if (equalStrings(string, (char *) pointerTo(dictionary[w].string)))
+            return w;
+    return EOF;
+}
+
+
 
 /* Word class query methods, move to Word.c */
 /* Word classes are numbers but in the dictionary they are generated as bits */
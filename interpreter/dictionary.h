@@ -23,6 +23,9 @@ extern int conjWord;        /* First conjunction in dictionary */
 
 
 /* FUNCTIONS */
+extern void indexDictionary(void);
+extern int findWord(char *string);
+
 extern bool isVerbWord(int wordIndex);
 extern bool isConjunctionWord(int wordIndex);
 extern bool isExceptWord(int wordIndex);
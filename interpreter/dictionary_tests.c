@@ -52,3 +52,72 @@ AfterEach(Dictionary) {
 
 Ensure(Dictionary, no_tests_yet) {
 }
+
+
+#define WORD_SIZE 4             /* Awords for each word string */
+
+static void given_dictionary_with(char *words[], int count) {
+    free(memory);
+    memory = allocate(count*WORD_SIZE*sizeof(Aword));
+    dictionary = allocate((count+1)*sizeof(DictionaryEntry));
+    for (int w = 0; w < count; w++) {
+        strcpy((char *)&memory[w*WORD_SIZE], words[w]);
+        dictionary[w].string = w*WORD_SIZE;
+    }
+    setEndOfArray(&dictionary[count]);
+    dictionarySize = count;
+    indexDictionary();
+}
+
+static int linearLookup(char *string) {
+    for (int w = 0; !isEndOfArray(&dictionary[w]); w++)
+        if (equalStrings(string, (char *)pointerTo(dictionary[w].string)))
+            return w;
+    return EOF;
+}
+
+
+Ensure(Dictionary, finds_words_ignoring_case) {
+    char *words[] = {"north", "take", "lamp", "\xe5ngstr\xf6m"};
+    given_dictionary_with(words, 4);
+
+    assert_that(findWord("take"), is_equal_to(1));
+    assert_that(findWord("LaMp"), is_equal_to(2));
+    assert_that(findWord("\xc5NGSTR\xd6M"), is_equal_to(3));
+    assert_that(findWord("lamps"), is_equal_to(EOF));
+    assert_that(findWord("lam"), is_equal_to(EOF));
+}
+
+Ensure(Dictionary, finds_first_of_words_equal_but_for_case) {
+    char *words[] = {"xyzzy", "Plugh", "plugh", "PLUGH"};
+    given_dictionary_with(words, 4);
+
+    assert_that(findWord("plugh"), is_equal_to(1));
+}
+
+/* Look up every word of a 10k word dictionary, and some unknown ones,
+   and check that the index finds the same as a search from the start */
+Ensure(Dictionary, finds_the_same_words_as_searching_in_a_large_dictionary) {
+#define LARGE_DICTIONARY 10000
+    static char strings[LARGE_DICTIONARY][WORD_SIZE*sizeof(Aword)];
+    static char *words[LARGE_DICTIONARY];
+    char unknown[WORD_SIZE*sizeof(Aword)];
+    int wrong = 0;
+    int w;
+
+    for (w = 0; w < LARGE_DICTIONARY; w++) {
+        sprintf(strings[w], "%c%cword%d", 'a'+w%26, 'a'+(w/26)%26, w);
+        words[w] = strings[w];
+    }
+    given_dictionary_with(words, LARGE_DICTIONARY);
+
+    for (w = 0; w < LARGE_DICTIONARY; w++) {
+        if (findWord(words[w]) != w || linearLookup(words[w]) != w)
+            wrong++;
+        sprintf(unknown, "%dx", w);
+        if (findWord(unknown) != EOF || linearLookup(unknown) != EOF)
+            wrong++;
+    }
+
+    assert_that(wrong, is_equal_to(0));
+}
@@ -2,13 +2,29 @@
 
 	event
 
+	Scheduled events are kept in a heap ordered on the time they are
+	due and the order in which they were scheduled, so that events due
+	at the same time run in the order they were scheduled. The time is
+	counted in calls to advanceEventTime(), once every turn.
+
+	The event queue (eventQueue[] with the time left 'after' for each
+	event, the next to run last) is the form used when saving and
+	undoing. exportEventQueue() and importEventQueue() convert between
+	the two.
+
 \*----------------------------------------------------------------------*/
 #include "event.h"
 
 /* IMPORTS */
+#include <stdlib.h>
+#include <string.h>
+
+#include "syserr.h"
+#include "memory.h"
 
 
 /* CONSTANTS */
+#define NOT_SCHEDULED (-1)
 
 
 /* PUBLIC DATA */
@@ -19,7 +35,224 @@ EventEntry *events;
 
 
 /* PRIVATE TYPES & DATA */
+typedef struct ScheduledEvent {
+    int due;                    /* The event time when it should run */
+    int order;                  /* Order in which it was scheduled */
+    int event;
+    int where;
+} ScheduledEvent;
+
+static ScheduledEvent *heap = NULL;
+static int heapSize = 0;
+static int heapCapacity = 0;
+
+static int *heapIndex = NULL;   /* Position in heap for each event */
+static int heapIndexSize = 0;
+
+static int eventTime = 0;
+static int scheduleOrder = 0;
+
+static bool eventQueueValid = true; /* eventQueue[] reflects the heap */
 
 
 /*+++++++++++++++++++++++++++++++++++++++++++++++++++*/
 
+
+/*----------------------------------------------------------------------*/
+static bool runsBefore(ScheduledEvent *a, ScheduledEvent *b) {
+    return a->due < b->due || (a->due == b->due && a->order < b->order);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void placeInHeap(int position, ScheduledEvent *scheduled) {
+    heap[position] = *scheduled;
+    heapIndex[scheduled->event] = position;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void siftUp(int position) {
+    ScheduledEvent moving = heap[position];
+
+    while (position > 0) {
+        int parent = (position-1)/2;
+        if (!runsBefore(&moving, &heap[parent]))
+            break;
+        placeInHeap(position, &heap[parent]);
+        position = parent;
+    }
+    placeInHeap(position, &moving);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void siftDown(int position) {
+    ScheduledEvent moving = heap[position];
+
+    for (;;) {
+        int child = 2*position+1;
+        if (child >= heapSize)
+            break;
+        if (child+1 < heapSize && runsBefore(&heap[child+1], &heap[child]))
+            child++;
+        if (!runsBefore(&heap[child], &moving))
+            break;
+        placeInHeap(position, &heap[child]);
+        position = child;
+    }
+    placeInHeap(position, &moving);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void removeFromHeap(int position) {
+    heapIndex[heap[position].event] = NOT_SCHEDULED;
+    heapSize--;
+    if (position == heapSize)
+        return;
+    placeInHeap(position, &heap[heapSize]);
+    siftDown(position);
+    siftUp(heapIndex[heap[heapSize].event]);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void ensureHeapRoomFor(int event) {
+    if (heapSize == heapCapacity) {
+        heapCapacity = heapCapacity == 0 ? 16 : 2*heapCapacity;
+        heap = realloc(heap, heapCapacity*sizeof(ScheduledEvent));
+        if (heap == NULL) syserr("Out of memory in ensureHeapRoomFor()");
+    }
+    if (event >= heapIndexSize) {
+        int newSize = heapIndexSize == 0 ? 16 : heapIndexSize;
+        int i;
+        while (newSize <= event)
+            newSize *= 2;
+        heapIndex = realloc(heapIndex, newSize*sizeof(int));
+        if (heapIndex == NULL) syserr("Out of memory in ensureHeapRoomFor()");
+        for (i = heapIndexSize; i < newSize; i++)
+            heapIndex[i] = NOT_SCHEDULED;
+        heapIndexSize = newSize;
+    }
+}
+
+
+/*======================================================================*/
+void scheduleEvent(int event, int where, int after) {
+    ScheduledEvent scheduled;
+
+    unscheduleEvent(event);
+    ensureHeapRoomFor(event);
+
+    scheduled.due = eventTime + after;
+    scheduled.order = scheduleOrder++;
+    scheduled.event = event;
+    scheduled.where = where;
+    placeInHeap(heapSize++, &scheduled);
+    siftUp(heapSize-1);
+    eventQueueValid = false;
+}
+
+
+/*======================================================================*/
+void unscheduleEvent(int event) {
+    if (event >= 0 && event < heapIndexSize && heapIndex[event] != NOT_SCHEDULED) {
+        removeFromHeap(heapIndex[event]);
+        eventQueueValid = false;
+    }
+}
+
+
+/*======================================================================*/
+/* Take the next event that is due, if any */
+bool nextDueEvent(EventQueueEntry *due) {
+    if (heapSize == 0 || heap[0].due > eventTime)
+        return false;
+
+    due->event = heap[0].event;
+    due->where = heap[0].where;
+    due->after = 0;
+    removeFromHeap(0);
+    eventQueueValid = false;
+    return true;
+}
+
+
+/*======================================================================*/
+void advanceEventTime(void) {
+    eventTime++;
+    if (heapSize > 0)
+        eventQueueValid = false;
+}
+
+
+/*======================================================================*/
+void clearEvents(void) {
+    while (heapSize > 0)
+        removeFromHeap(heapSize-1);
+    eventTime = 0;
+    scheduleOrder = 0;
+    eventQueueTop = 0;
+    eventQueueValid = true;
+}
+
+
+/*----------------------------------------------------------------------*/
+static int compareScheduledEvents(const void *a, const void *b) {
+    /* Those to run last first */
+    if (runsBefore((ScheduledEvent *)a, (ScheduledEvent *)b))
+        return 1;
+    if (runsBefore((ScheduledEvent *)b, (ScheduledEvent *)a))
+        return -1;
+    return 0;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void increaseEventQueue(int size) {
+    eventQueue = realloc(eventQueue, size*sizeof(EventQueueEntry));
+    if (eventQueue == NULL) syserr("Out of memory in increaseEventQueue()");
+
+    eventQueueSize = size;
+}
+
+
+/*======================================================================*/
+/* Make eventQueue[] show the scheduled events */
+void exportEventQueue(void) {
+    ScheduledEvent *sorted;
+    int i;
+
+    if (eventQueueValid)
+        return;
+
+    if (eventQueue == NULL || heapSize > eventQueueSize)
+        increaseEventQueue(heapSize > 2*eventQueueSize ? heapSize : 2*eventQueueSize+2);
+
+    sorted = allocate((heapSize+1)*sizeof(ScheduledEvent));
+    memcpy(sorted, heap, heapSize*sizeof(ScheduledEvent));
+    qsort(sorted, heapSize, sizeof(ScheduledEvent), compareScheduledEvents);
+    for (i = 0; i < heapSize; i++) {
+        eventQueue[i].after = sorted[i].due - eventTime;
+        eventQueue[i].event = sorted[i].event;
+        eventQueue[i].where = sorted[i].where;
+    }
+    eventQueueTop = heapSize;
+    deallocate(sorted);
+
+    eventQueueValid = true;
+}
+
+
+/*======================================================================*/
+/* Schedule the events in eventQueue[], e.g. after restoring it */
+void importEventQueue(void) {
+    int i;
+
+    while (heapSize > 0)
+        removeFromHeap(heapSize-1);
+    for (i = eventQueueTop-1; i >= 0; i--)
+        scheduleEvent(eventQueue[i].event, eventQueue[i].where, eventQueue[i].after);
+    eventQueueValid = true;
+}
@@ -30,5 +30,12 @@ extern EventEntry *events;  /* Event table pointer */
 
 
 /* FUNCTIONS */
+extern void scheduleEvent(int event, int where, int after);
+extern void unscheduleEvent(int event);
+extern bool nextDueEvent(EventQueueEntry *due);
+extern void advanceEventTime(void);
+extern void clearEvents(void);
+extern void exportEventQueue(void);
+extern void importEventQueue(void);
 
 #endif /* EVENT_H_ */
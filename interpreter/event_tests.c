@@ -0,0 +1,124 @@
+#include <cgreen/cgreen.h>
+
+#include "event.h"
+
+#include "memory.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "instance.mock"
+
+
+static int runDueEvents(int run[]) {
+    EventQueueEntry due;
+    int count = 0;
+
+    while (nextDueEvent(&due))
+        run[count++] = due.event;
+    advanceEventTime();
+    return count;
+}
+
+
+Describe(Event);
+BeforeEach(Event) {
+    clearEvents();
+}
+AfterEach(Event) {}
+
+
+Ensure(Event, runs_events_when_due) {
+    int run[5];
+
+    scheduleEvent(1, 10, 2);
+    scheduleEvent(2, 10, 0);
+
+    assert_that(runDueEvents(run), is_equal_to(1));
+    assert_that(run[0], is_equal_to(2));
+    assert_that(runDueEvents(run), is_equal_to(0));
+    assert_that(runDueEvents(run), is_equal_to(1));
+    assert_that(run[0], is_equal_to(1));
+    assert_that(runDueEvents(run), is_equal_to(0));
+}
+
+Ensure(Event, runs_events_due_at_the_same_time_in_the_order_scheduled) {
+    int run[5];
+
+    scheduleEvent(3, 10, 2);
+    runDueEvents(run);
+    scheduleEvent(1, 10, 1);
+    scheduleEvent(2, 10, 1);
+
+    assert_that(runDueEvents(run), is_equal_to(0));
+    assert_that(runDueEvents(run), is_equal_to(3));
+    assert_that(run[0], is_equal_to(3));
+    assert_that(run[1], is_equal_to(1));
+    assert_that(run[2], is_equal_to(2));
+}
+
+Ensure(Event, reschedules_an_event_already_scheduled) {
+    int run[5];
+
+    scheduleEvent(1, 10, 0);
+    scheduleEvent(2, 10, 0);
+    scheduleEvent(1, 20, 0);
+
+    assert_that(runDueEvents(run), is_equal_to(2));
+    assert_that(run[0], is_equal_to(2));
+    assert_that(run[1], is_equal_to(1));
+}
+
+Ensure(Event, can_cancel_any_event) {
+    int run[100];
+    int event;
+
+    for (event = 1; event <= 50; event++)
+        scheduleEvent(event, 10, event%3);
+    for (event = 1; event <= 50; event += 2)
+        unscheduleEvent(event);
+    unscheduleEvent(99);
+
+    assert_that(runDueEvents(run), is_equal_to(8));
+    for (event = 0; event < 8; event++)
+        assert_that(run[event]%6, is_equal_to(0));
+}
+
+Ensure(Event, exports_event_queue_with_next_to_run_last) {
+    int run[5];
+
+    scheduleEvent(1, 10, 3);
+    runDueEvents(run);
+    scheduleEvent(2, 20, 1);
+    scheduleEvent(3, 30, 2);
+
+    exportEventQueue();
+
+    assert_that(eventQueueTop, is_equal_to(3));
+    assert_that(eventQueueSize, is_greater_than(2));
+    assert_that(eventQueue[2].event, is_equal_to(2));
+    assert_that(eventQueue[2].after, is_equal_to(1));
+    assert_that(eventQueue[2].where, is_equal_to(20));
+    assert_that(eventQueue[1].event, is_equal_to(1));
+    assert_that(eventQueue[1].after, is_equal_to(2));
+    assert_that(eventQueue[0].event, is_equal_to(3));
+    assert_that(eventQueue[0].after, is_equal_to(2));
+}
+
+Ensure(Event, runs_imported_events_in_the_same_order) {
+    int run[5];
+
+    scheduleEvent(1, 10, 1);
+    scheduleEvent(2, 10, 1);
+    scheduleEvent(3, 10, 0);
+    exportEventQueue();
+
+    clearEvents();
+    eventQueueTop = 3;
+    importEventQueue();
+
+    assert_that(runDueEvents(run), is_equal_to(1));
+    assert_that(run[0], is_equal_to(3));
+    assert_that(runDueEvents(run), is_equal_to(2));
+    assert_that(run[0], is_equal_to(1));
+    assert_that(run[1], is_equal_to(2));
+}
@@ -20,8 +20,10 @@
 #include "term.h"
 #include "utils.h"
 #include "instance.h"
+#include "containment.h"
 #include "inter.h"
 #include "decode.h"
+#include "textcache.h"
 #include "save.h"
 #include "memory.h"
 #include "output.h"
@@ -33,6 +35,7 @@
 #include "actor.h"
 #include "options.h"
 #include "args.h"
+#include "replay.h"
 
 
 #ifdef USE_READLINE
@@ -65,6 +68,7 @@ jmp_buf forfeitLabel;       /* Player forfeit by an empty command */
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 static char transcriptFileName[256] = "";
 static char commandLogFileName[256] = "";
+static bool printing = false;   /* Printing a text already? */
 
 /*======================================================================*/
 void setStyle(int style)
@@ -80,65 +84,85 @@ void setStyle(int style)
 #endif
 }
 
+/*----------------------------------------------------------------------*/
+static char *decodedText(Aword fpos, Aword len)
+{
+    char *text = findCachedText(fpos, len);
+    int ch;
+    int i;
+
+    if (text != NULL)
+        return text;
+
+    text = allocate(len+1);
+
+    /* Position to start of text */
+    positionText(fpos+header->stringOffset);
+
+    if (header->pack)
+        startDecoding();
+    for (i = 0; i != len; i++) {
+        if (header->pack)
+            ch = decodeChar();
+        else
+            ch = readTextChar();
+        if (ch == EOFChar || ch == EOF) /* End of text? */
+            break;
+        text[i] = ch;
+    }
+    text[i] = '\0';
+
+    cacheText(fpos, len, text);
+    return text;
+}
+
+
 /*======================================================================*/
 void print(Aword fpos, Aword len)
 {
     char str[2*WIDTH];            /* String buffer */
+    char *text;
     int outlen = 0;               /* Current output length */
-    int ch = 0;
     int i;
-    long savfp = 0;     /* Temporary saved text file position */
-    static bool printFlag = false; /* Printing already? */
-    bool savedPrintFlag = printFlag;
-    void *info = NULL;      /* Saved decoding info */
+    bool wasPrinting = printing;
 
 
     if (len == 0) return;
 
     if (isHere(HERO, true)) {   /* Check if the player will see it */
-        if (printFlag) {            /* Already printing? */
-            /* Save current text file position and/or decoding info */
-            if (header->pack)
-                info = pushDecode();
-            else
-                savfp = ftell(textFile);
-        }
-        printFlag = true;           /* We're printing now! */
-
-        /* Position to start of text */
-        fseek(textFile, fpos+header->stringOffset, 0);
-
-        if (header->pack)
-            startDecoding();
-        for (outlen = 0; outlen != len; outlen = outlen + strlen(str)) {
-            /* Fill the buffer from the beginning */
-            for (i = 0; i <= WIDTH || (i > WIDTH && ch != ' '); i++) {
-                if (outlen + i == len)  /* No more characters? */
-                    break;
-                if (header->pack)
-                    ch = decodeChar();
-                else
-                    ch = getc(textFile);
-                if (ch == EOFChar)      /* Or end of text? */
-                    break;
-                str[i] = ch;
+        /* Output may print other texts, but the cache keeps ours */
+        printing = true;
+        text = decodedText(fpos, len);
+        if (outputSuppressed)
+            /* Nothing to format, but parameters in it still run code */
+            output(text);
+        else
+            for (outlen = 0; text[outlen] != '\0'; outlen = outlen + i) {
+                /* Fill the buffer from the beginning, up to a space after WIDTH */
+                for (i = 0; text[outlen+i] != '\0' && (i <= WIDTH || str[i-1] != ' '); i++)
+                    str[i] = text[outlen+i];
+                str[i] = '\0';
+                output(str);
             }
-            str[i] = '\0';
-            output(str);
-        }
 
         /* And restore */
-        printFlag = savedPrintFlag;
-        if (printFlag) {
-            if (header->pack)
-                popDecode(info);
-            else
-                fseek(textFile, savfp, 0);
-        }
+        printing = wasPrinting;
+        if (!printing)
+            trimTextCache();
     }
 }
 
 
+/*======================================================================*/
+/* Forget the texts being printed when a command is abandoned with a
+   longjmp() from within print(), so the text cache is trimmed again */
+void abandonPrinting(void)
+{
+    printing = false;
+    trimTextCache();
+}
+
+
 /*======================================================================*/
 void sys(Aword fpos, Aword len)
 {
@@ -155,21 +179,10 @@ void sys(Aword fpos, Aword len)
 char *getStringFromFile(Aword fpos, Aword len)
 {
     char *buf = allocate(len+1);
-    char *bufp = buf;
-
-    /* Position to start of text */
-    fseek(textFile, fpos+header->stringOffset, 0);
-
-    if (header->pack)
-        startDecoding();
-    while (len--)
-        if (header->pack)
-            *(bufp++) = decodeChar();
-        else
-            *(bufp++) = getc(textFile);
 
-    /* Terminate string with zero */
-    *bufp = '\0';
+    strcpy(buf, decodedText(fpos, len));
+    if (!printing)
+        trimTextCache();
 
     return buf;
 }
@@ -180,7 +193,7 @@ char *getStringFromFile(Aword fpos, Aword len)
 void score(Aword sc)
 {
     if (sc == 0) {
-        ParameterArray messageParameters = newParameterArray();
+        ParameterArray messageParameters = newTemporaryParameterArray();
         addParameterForInteger(messageParameters, current.score);
         addParameterForInteger(messageParameters, header->maximumScore);
         addParameterForInteger(messageParameters, current.tick);
@@ -233,6 +246,8 @@ void quitGame(void)
     char buf[80];
 
     current.location = where(HERO, DIRECT);
+    /* The command log can't say what to do now, so let the player */
+    endReplay();
     para();
     while (true) {
         col = 1;
@@ -288,61 +303,16 @@ void restartGame(void)
 /*======================================================================*/
 void cancelEvent(Aword theEvent)
 {
-    int i;
-
-    for (i = eventQueueTop-1; i>=0; i--)
-        if (eventQueue[i].event == theEvent) {
-            while (i < eventQueueTop-1) {
-                eventQueue[i].event = eventQueue[i+1].event;
-                eventQueue[i].after = eventQueue[i+1].after;
-                eventQueue[i].where = eventQueue[i+1].where;
-                i++;
-            }
-            eventQueueTop--;
-            return;
-        }
-}
-
-
-/*----------------------------------------------------------------------*/
-static void increaseEventQueue(void)
-{
-    eventQueue = realloc(eventQueue, (eventQueueTop+2)*sizeof(EventQueueEntry));
-    if (eventQueue == NULL) syserr("Out of memory in increaseEventQueue()");
-
-    eventQueueSize = eventQueueTop + 2;
-}
-
-
-/*----------------------------------------------------------------------*/
-static void moveEvent(int to, int from) {
-    eventQueue[to].event = eventQueue[from].event;
-    eventQueue[to].after = eventQueue[from].after;
-    eventQueue[to].where = eventQueue[from].where;
+    unscheduleEvent(theEvent);
 }
 
 
 /*======================================================================*/
 void schedule(Aword event, Aword where, Aword after)
 {
-    int i;
-
     if (event == 0) syserr("NULL event");
 
-    cancelEvent(event);
-    /* Check for overflow */
-    if (eventQueue == NULL || eventQueueTop == eventQueueSize)
-        increaseEventQueue();
-
-    /* Bubble this event down */
-    for (i = eventQueueTop; i >= 1 && eventQueue[i-1].after <= after; i--) {
-        moveEvent(i, i-1);
-    }
-
-    eventQueue[i].after = after;
-    eventQueue[i].where = where;
-    eventQueue[i].event = event;
-    eventQueueTop++;
+    scheduleEvent(event, where, after);
 }
 
 
@@ -527,12 +497,13 @@ int getContainerMember(int container, int index, bool directly) {
     Aint i;
     Aint count = 0;
 
-    for (i = 1; i <= header->instanceMax; i++) {
-        if (isIn(i, container, DIRECT)) {
-            count++;
-            if (count == index)
-                return i;
-        }
+    if (!isAContainer(container))
+        syserr("IN in a non-container.");
+
+    for (i = firstContained(container); i != 0; i = nextContained(container, i)) {
+        count++;
+        if (count == index)
+            return i;
     }
     apperr("Index not in container in 'containerMember()'");
     return 0;
@@ -610,11 +581,11 @@ void use(int actor, int script)
         syserr(str);
     }
 
-    admin[actor].script = script;
-    admin[actor].step = 0;
+    admin.script[actor] = script;
+    admin.step[actor] = 0;
     step = stepOf(actor);
     if (step != NULL && step->after != 0) {
-        admin[actor].waitCount = evaluate(step->after);
+        admin.waitCount[actor] = evaluate(step->after);
     }
 
     gameStateChanged = true;
@@ -630,8 +601,8 @@ void stop(int act)
         syserr(str);
     }
 
-    admin[act].script = 0;
-    admin[act].step = 0;
+    admin.script[act] = 0;
+    admin.step[act] = 0;
 
     gameStateChanged = true;
 }
@@ -734,6 +705,9 @@ void startTranscript(void) {
     if (transcriptFile != NULL)
         return;
 
+    /* Only what is output from now on belongs in the transcript */
+    discardTranscript();
+
     createLogfileName(transcriptFileName, ".a3t");
 #ifdef HAVE_GLK
     glui32 fileUsage = fileusage_Transcript;
@@ -783,6 +757,8 @@ void stopTranscript(void) {
     if (transcriptFile == NULL)
         return;
 
+    flushTranscript();
+
     if (transcriptOption)
 #ifdef HAVE_GLK
         glk_stream_close(transcriptFile, NULL);
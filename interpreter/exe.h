@@ -41,6 +41,7 @@ extern Aptr strip(bool stripFromBeginningNotEnd, int count, bool stripWordsNotCh
 extern Aptr concat(Aptr s1, Aptr s2);
 extern char *getStringFromFile(Aword fpos, Aword len);
 extern void print(Aword fpos, Aword len);
+extern void abandonPrinting(void);
 extern void setStyle(int style);
 extern void showImage(int image, int align);
 extern void playSound(int sound);
@@ -13,6 +13,7 @@
 
 #include "class.h"
 #include "Container.h"
+#include "containment.h"
 
 
 static void tearDown() {
@@ -150,6 +151,7 @@ static void writeAndOpenGetStringTestFile(int fpos, char *testString)
   fprintf(testFile, "%s", testString);
   fclose(testFile);
   textFile = fopen(testFileName, "rb");
+  loadText(textFile);
 }
 
 
@@ -170,20 +172,6 @@ Ensure(Exe, canGetString)
 }
 
 
-/*----------------------------------------------------------------------*/
-Ensure(Exe, testIncreaseEventQueue) {
-  eventQueueSize = 0;
-  eventQueue = NULL;
-  eventQueueTop = 0;
-
-  increaseEventQueue();
-
-  assert_true(eventQueueSize != 0);
-  assert_true(eventQueue != NULL);
-}
-
-
-
 /*----------------------------------------------------------------------*/
 static bool syserrHandlerCalled;
 
@@ -285,7 +273,7 @@ Ensure(Exe, callingWhereReturnsExpectedValues) {
     int FOURTH_INSTANCE = THIRD_INSTANCE + 1;
     int MAX_INSTANCE = FOURTH_INSTANCE + 1;
 
-  admin = allocate(MAX_INSTANCE*sizeof(AdminEntry));
+  admin.location = allocate(MAX_INSTANCE*sizeof(Aint));
   instances = allocate(MAX_INSTANCE*sizeof(InstanceEntry));
   classes = allocate(MAX_INSTANCE*sizeof(ClassEntry));
   header = allocate(sizeof(ACodeHeader));
@@ -294,26 +282,26 @@ Ensure(Exe, callingWhereReturnsExpectedValues) {
   header->instanceMax = MAX_INSTANCE;
 
   instances[FIRST_INSTANCE].parent = LOCATION_CLASS;	/* A location */
-  admin[FIRST_INSTANCE].location = THIRD_INSTANCE;
+  admin.location[FIRST_INSTANCE] = THIRD_INSTANCE;
   assert_true(where(FIRST_INSTANCE, DIRECT) == 0);	/* Locations are always nowhere */
   assert_true(where(FIRST_INSTANCE, TRANSITIVE) == 0);
 
   instances[SECOND_INSTANCE].parent = 0;	/* Not a location */
-  admin[SECOND_INSTANCE].location = FIRST_INSTANCE;	/* At FIRST_INSTANCE */
+  admin.location[SECOND_INSTANCE] = FIRST_INSTANCE;	/* At FIRST_INSTANCE */
   assert_true(where(SECOND_INSTANCE, DIRECT) == FIRST_INSTANCE);
   assert_true(where(SECOND_INSTANCE, TRANSITIVE) == FIRST_INSTANCE);
 
   instances[THIRD_INSTANCE].parent = 0;	/* Not a location */
-  admin[THIRD_INSTANCE].location = SECOND_INSTANCE;	/* In SECOND_INSTANCE which is at FIRST_INSTANCE */
+  admin.location[THIRD_INSTANCE] = SECOND_INSTANCE;	/* In SECOND_INSTANCE which is at FIRST_INSTANCE */
   assert_true(where(THIRD_INSTANCE, DIRECT) == SECOND_INSTANCE);
   assert_true(where(THIRD_INSTANCE, TRANSITIVE) == FIRST_INSTANCE);
 
   instances[FOURTH_INSTANCE].parent = 0;	/* Not a location */
-  admin[FOURTH_INSTANCE].location = THIRD_INSTANCE; /* In THIRD which is in SECOND which is at FIRST */
+  admin.location[FOURTH_INSTANCE] = THIRD_INSTANCE; /* In THIRD which is in SECOND which is at FIRST */
   assert_true(where(FOURTH_INSTANCE, DIRECT) == THIRD_INSTANCE);
   assert_true(where(FOURTH_INSTANCE, TRANSITIVE) == FIRST_INSTANCE);
 
-  free(admin);
+  free(admin.location);
   free(instances);
   free(classes);
   free(header);
@@ -341,18 +329,20 @@ Ensure(Exe, canGetMembersOfASet) {
 Ensure(Exe, canGetContainerSize) {
   header = allocate(sizeof(ACodeHeader));
   instances = allocate(4*sizeof(InstanceEntry));
-  admin = allocate(4*sizeof(AdminEntry));
+  admin.location = allocate(4*sizeof(Aint));
 
   header->instanceMax = 3;
   instances[1].container = 1;
-  admin[1].location = 0;
-  admin[2].location = 1;
-  admin[3].location = 2;
+  admin.location[1] = 0;
+  admin.location[2] = 1;
+  admin.location[3] = 2;
+  indexContainment();
 
   assert_true(containerSize(1, DIRECT) == 1);
   assert_true(containerSize(1, TRANSITIVE) == 2);
 
-  free(admin);
+  freeContainment();
+  free(admin.location);
   free(instances);
   free(header);
 }
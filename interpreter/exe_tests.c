@@ -14,15 +14,18 @@
 #include "utils.mock"
 #include "current.mock"
 #include "syserr.mock"
+#include "containment.mock"
 #include "args.mock"
 #include "instance.mock"
 #include "decode.mock"
+#include "textcache.mock"
 #include "params.mock"
 #include "msg.mock"
 #include "score.mock"
 #include "state.mock"
 #include "term.mock"
 #include "readline.mock"
+#include "replay.mock"
 #include "save.mock"
 #include "word.mock"
 #include "event.mock"
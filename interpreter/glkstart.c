@@ -48,6 +48,11 @@ glkunix_argumentlist_t glkunix_arguments[] = {
     { "-t", glkunix_arg_ValueCanFollow, "[<n>] trace game execution, higher <n> gives more trace" },
     { "-r", glkunix_arg_NoValue, "make regression testing easier (don't timestamp, page break, randomize...)" },
     { "-e", glkunix_arg_NoValue, "ignore version and checksum errors (dangerous)" },
+    { "-undo", glkunix_arg_ValueCanFollow, "<n> only keep the last <n> moves for undo" },
+    { "-cache", glkunix_arg_ValueCanFollow, "<n> keep at most <n> kilobytes of decoded text (default 256)" },
+    { "-profile", glkunix_arg_NoValue, "count executed instructions and write a profile ('.a3p')" },
+    { "-image", glkunix_arg_NoValue, "keep a native image of the game ('.a3n') for faster start" },
+    { "-checkrules", glkunix_arg_NoValue, "also evaluate unchanged rules and check that they agree" },
     { "--version", glkunix_arg_NoValue, "print version and exit" },
     { "", glkunix_arg_ValueFollows, "filename: The game file to load." },
     { NULL, glkunix_arg_End, NULL }
@@ -0,0 +1,190 @@
+/*----------------------------------------------------------------------*\
+
+  image
+
+  The game memory is loaded from the Acode file, checksummed and, on
+  little-endian machines, reversed at every start. With -image the
+  result is also written to an image file next to the game ('.a3n'),
+  and then used instead as long as it is valid, i.e. made for the same
+  game, by an interpreter with the same word size and byte order, and
+  not older than the game file.
+
+  Where possible the image is mapped into memory, privately so that
+  the file is never changed, and pages are only read when used.
+
+\*----------------------------------------------------------------------*/
+#include "image.h"
+
+/* IMPORTS */
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "args.h"
+#include "memory.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HAVE_MMAP
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#endif
+
+
+/* CONSTANTS */
+#define IMAGE_EXTENSION ".a3n"
+#define IMAGE_FORMAT 1
+#define BYTE_ORDER_MARK 0x01020304
+
+
+/* PRIVATE TYPES */
+typedef struct ImageHeader {
+    char tag[4];                /* "A3N\0" */
+    Aword format;               /* IMAGE_FORMAT */
+    Aword byteOrder;            /* BYTE_ORDER_MARK in native order */
+    Aword wordSize;             /* sizeof(Aword) */
+    Aword size;                 /* Words of memory following */
+    ACodeHeader gameHeader;     /* The header of the game, in native order */
+} ImageHeader;
+
+
+/* PRIVATE DATA */
+static void *mappedImage = NULL;
+static size_t mappedSize = 0;
+
+
+/*----------------------------------------------------------------------*/
+static char *imageFileName(void) {
+    char *fileName = allocate(strlen(adventureFileName)+strlen(IMAGE_EXTENSION)+1);
+    char *extension;
+
+    strcpy(fileName, adventureFileName);
+    extension = strrchr(fileName, '.');
+    if (extension != NULL && strchr(extension, '/') == NULL)
+        *extension = '\0';
+    strcat(fileName, IMAGE_EXTENSION);
+    return fileName;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool olderThanGame(char *fileName) {
+    struct stat imageStatus, gameStatus;
+
+    if (stat(fileName, &imageStatus) != 0 || stat(adventureFileName, &gameStatus) != 0)
+        return true;
+    return imageStatus.st_mtime < gameStatus.st_mtime;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool validHeader(ImageHeader *imageHeader, ACodeHeader *gameHeader, long fileSize) {
+    return memcmp(imageHeader->tag, "A3N", 4) == 0
+        && imageHeader->format == IMAGE_FORMAT
+        && imageHeader->byteOrder == BYTE_ORDER_MARK
+        && imageHeader->wordSize == sizeof(Aword)
+        && imageHeader->size == gameHeader->size
+        && memcmp(&imageHeader->gameHeader, gameHeader, sizeof(ACodeHeader)) == 0
+        && fileSize == (long)(sizeof(ImageHeader) + imageHeader->size*sizeof(Aword));
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool readImage(FILE *file, ACodeHeader *gameHeader) {
+    ImageHeader imageHeader;
+    long fileSize;
+
+    if (fseek(file, 0, SEEK_END) != 0)
+        return false;
+    fileSize = ftell(file);
+    rewind(file);
+    if (fread(&imageHeader, sizeof(imageHeader), 1, file) != 1
+        || !validHeader(&imageHeader, gameHeader, fileSize))
+        return false;
+
+#ifdef HAVE_MMAP
+    mappedImage = mmap(NULL, fileSize, PROT_READ|PROT_WRITE, MAP_PRIVATE, fileno(file), 0);
+    if (mappedImage != MAP_FAILED) {
+        mappedSize = fileSize;
+        memory = (Aword *)((char *)mappedImage + sizeof(ImageHeader));
+        memTop = imageHeader.size;
+        return true;
+    }
+    mappedImage = NULL;
+#endif
+
+    memory = allocate(imageHeader.size*sizeof(Aword));
+    if (fread(memory, sizeof(Aword), imageHeader.size, file) != imageHeader.size) {
+        deallocate(memory);
+        memory = NULL;
+        return false;
+    }
+    memTop = imageHeader.size;
+    return true;
+}
+
+
+/*======================================================================*/
+/* Load the memory from the image of the game, if there is a valid one */
+bool loadImage(ACodeHeader *gameHeader) {
+    char *fileName = imageFileName();
+    FILE *file = NULL;
+    bool loaded = false;
+
+    if (memory == NULL && !olderThanGame(fileName))
+        file = fopen(fileName, "rb");
+    if (file != NULL) {
+        loaded = readImage(file, gameHeader);
+        fclose(file);
+    }
+    deallocate(fileName);
+    return loaded;
+}
+
+
+/*======================================================================*/
+/* Save the loaded memory as the image of the game, through a temporary
+   file so that a concurrently started game never sees half an image */
+void saveImage(ACodeHeader *gameHeader) {
+    char *fileName = imageFileName();
+    char *temporaryName = allocate(strlen(fileName)+strlen(".tmp")+1);
+    ImageHeader imageHeader;
+    FILE *file;
+    bool written;
+
+    memset(&imageHeader, 0, sizeof(imageHeader));
+    memcpy(imageHeader.tag, "A3N", 4);
+    imageHeader.format = IMAGE_FORMAT;
+    imageHeader.byteOrder = BYTE_ORDER_MARK;
+    imageHeader.wordSize = sizeof(Aword);
+    imageHeader.size = memTop;
+    imageHeader.gameHeader = *gameHeader;
+
+    sprintf(temporaryName, "%s.tmp", fileName);
+    file = fopen(temporaryName, "wb");
+    if (file != NULL) {
+        written = fwrite(&imageHeader, sizeof(imageHeader), 1, file) == 1
+            && fwrite(memory, sizeof(Aword), memTop, file) == (size_t)memTop;
+        if (fclose(file) == 0 && written)
+            rename(temporaryName, fileName);
+        else
+            remove(temporaryName);
+    }
+    deallocate(temporaryName);
+    deallocate(fileName);
+}
+
+
+/*======================================================================*/
+/* Release the memory if it is a mapped image, true if it was */
+bool unloadImage(void) {
+#ifdef HAVE_MMAP
+    if (mappedImage != NULL) {
+        munmap(mappedImage, mappedSize);
+        mappedImage = NULL;
+        memory = NULL;
+        return true;
+    }
+#endif
+    return false;
+}
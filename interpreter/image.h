@@ -0,0 +1,31 @@
+#ifndef IMAGE_H_
+#define IMAGE_H_
+/*----------------------------------------------------------------------*\
+
+  image
+
+  A cached image of the game memory, already in native byte order,
+  which is written next to the game ('.a3n') and mapped directly
+  into memory the next time, when running with -image.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern bool loadImage(ACodeHeader *gameHeader);
+extern void saveImage(ACodeHeader *gameHeader);
+extern bool unloadImage(void);
+
+#endif /* IMAGE_H_ */
@@ -0,0 +1,97 @@
+#include <cgreen/cgreen.h>
+
+#include "image.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <utime.h>
+#include <time.h>
+
+#include "memory.h"
+#include "acode.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "args.mock"
+#include "instance.mock"
+
+
+#define GAME_FILE_NAME "image_tests.a3c"
+#define IMAGE_FILE_NAME "image_tests.a3n"
+#define MEMORY_SIZE 100
+
+static ACodeHeader gameHeader;
+static Aword savedMemory[MEMORY_SIZE];
+
+
+static void given_a_loaded_game(void) {
+    int i;
+
+    memory = allocate(MEMORY_SIZE*sizeof(Aword));
+    for (i = 0; i < MEMORY_SIZE; i++)
+        memory[i] = i*0x01010101;
+    memTop = MEMORY_SIZE;
+    memcpy(savedMemory, memory, sizeof(savedMemory));
+}
+
+static void unloaded(void) {
+    if (!unloadImage())
+        deallocate(memory);
+    memory = NULL;
+    memTop = 0;
+}
+
+
+Describe(Image);
+BeforeEach(Image) {
+    FILE *gameFile = fopen(GAME_FILE_NAME, "w");
+    fclose(gameFile);
+    adventureFileName = GAME_FILE_NAME;
+
+    memset(&gameHeader, 0, sizeof(gameHeader));
+    gameHeader.size = MEMORY_SIZE;
+    gameHeader.acdcrc = 0x1234;
+    memory = NULL;
+}
+AfterEach(Image) {
+    unloaded();
+    remove(GAME_FILE_NAME);
+    remove(IMAGE_FILE_NAME);
+}
+
+
+Ensure(Image, loads_the_same_memory_as_was_saved) {
+    given_a_loaded_game();
+    saveImage(&gameHeader);
+    unloaded();
+
+    assert_that(loadImage(&gameHeader), is_true);
+    assert_that(memTop, is_equal_to(MEMORY_SIZE));
+    assert_that(memcmp(memory, savedMemory, sizeof(savedMemory)), is_equal_to(0));
+}
+
+Ensure(Image, is_not_loaded_for_another_game) {
+    given_a_loaded_game();
+    saveImage(&gameHeader);
+    unloaded();
+
+    gameHeader.acdcrc++;
+    assert_that(loadImage(&gameHeader), is_false);
+    assert_that(memory, is_null);
+}
+
+Ensure(Image, is_not_loaded_when_older_than_the_game) {
+    struct utimbuf later;
+
+    given_a_loaded_game();
+    saveImage(&gameHeader);
+    unloaded();
+
+    later.actime = later.modtime = time(NULL)+10;
+    utime(GAME_FILE_NAME, &later);
+    assert_that(loadImage(&gameHeader), is_false);
+}
+
+Ensure(Image, is_not_loaded_when_there_is_none) {
+    assert_that(loadImage(&gameHeader), is_false);
+}
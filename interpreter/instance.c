@@ -18,19 +18,144 @@
 #include "dictionary.h"
 #include "Location.h"
 #include "compatibility.h"
+#include "containment.h"
 
 
 /* PUBLIC DATA */
 
 InstanceEntry *instances;   /* Instance table pointer */
 
-AdminEntry *admin;      /* Administrative data about instances */
+Admin admin;            /* Administrative data about instances */
 AttributeEntry *attributes; /* Dynamic attribute values */
 
+
+/* PRIVATE DATA */
+
+/* A row of bits for every class, with the bits set for the class
+   itself and all its ancestors, so isA() is only a bit test */
+static Aword *ancestors = NULL;
+static int ancestorClassMax = 0;
+static int ancestorWords = 0;
+
+/* The results of locationOf(), which are forgotten when the instance
+   or anything it is in or at is moved */
+#define UNKNOWN_LOCATION (-1)
+#define FOLLOWS_HERO (-2)       /* An entity, always where the hero is */
+static Aint *knownLocations = NULL;
+static int knownLocationsMax = 0;
+
+/* When attributes and locations were last changed, so that what was
+   computed from them can tell if it is still valid. Attributes are
+   stamped in buckets on their code modulo ATTRIBUTE_BUCKETS. */
+static ChangeStamp changeStamp = 0;
+static ChangeStamp attributeChangeStamps[ATTRIBUTE_BUCKETS];
+static ChangeStamp locationChangeStamp = 0;
+
+/* A bit for every page of ATTRIBUTE_PAGE_WORDS words in the attribute
+   area that was written since forgetWrittenAttributes(), so that the
+   undo journal only has to compare those */
+#define PAGES_PER_WORD 64
+static uint64_t *writtenAttributePages = NULL;
+static int writtenAttributeWords = 0;
+
 /*+++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 
 /* Instance query methods */
 
+/*======================================================================*/
+void allocateAdmin(void)
+{
+    int count = header->instanceMax+1;
+
+    deallocate(admin.location);
+    deallocate(admin.attributes);
+    deallocate(admin.alreadyDescribed);
+    deallocate(admin.visitsCount);
+    deallocate(admin.script);
+    deallocate(admin.step);
+    deallocate(admin.waitCount);
+
+    admin.location = allocate(count*sizeof(Aint));
+    admin.attributes = allocate(count*sizeof(AttributeEntry *));
+    admin.alreadyDescribed = allocate(count*sizeof(Abool));
+    admin.visitsCount = allocate(count*sizeof(Aint));
+    admin.script = allocate(count*sizeof(Aint));
+    admin.step = allocate(count*sizeof(Aint));
+    admin.waitCount = allocate(count*sizeof(Aint));
+
+    if (writtenAttributePages != NULL)
+        deallocate(writtenAttributePages);
+    writtenAttributeWords = (header->attributesAreaSize/ATTRIBUTE_PAGE_WORDS)/PAGES_PER_WORD + 1;
+    writtenAttributePages = allocate(writtenAttributeWords*sizeof(uint64_t));
+}
+
+
+/*======================================================================*/
+/* The administrative data of an instance as it is saved */
+void getAdminEntry(int instance, AdminEntry *entry)
+{
+    memset(entry, 0, sizeof(AdminEntry)); /* No stray padding in save files */
+    entry->location = admin.location[instance];
+    entry->attributes = admin.attributes[instance];
+    entry->alreadyDescribed = admin.alreadyDescribed[instance];
+    entry->visitsCount = admin.visitsCount[instance];
+    entry->script = admin.script[instance];
+    entry->step = admin.step[instance];
+    entry->waitCount = admin.waitCount[instance];
+}
+
+
+/*======================================================================*/
+/* Restore the administrative data of an instance, except its attribute
+   area which never moves */
+void setAdminEntry(int instance, AdminEntry *entry)
+{
+    admin.location[instance] = entry->location;
+    admin.alreadyDescribed[instance] = entry->alreadyDescribed;
+    admin.visitsCount[instance] = entry->visitsCount;
+    admin.script[instance] = entry->script;
+    admin.step[instance] = entry->step;
+    admin.waitCount[instance] = entry->waitCount;
+}
+
+
+/*======================================================================*/
+void indexAncestors(void)
+{
+    int theClass, ancestor;
+
+    freeAncestors();
+
+    ancestorClassMax = header->classMax;
+    ancestorWords = ancestorClassMax/32 + 1;
+    ancestors = allocate((ancestorClassMax+1)*ancestorWords*sizeof(Aword));
+
+    for (theClass = 1; theClass <= ancestorClassMax; theClass++)
+        for (ancestor = theClass; ancestor > 0 && ancestor <= ancestorClassMax; ancestor = classes[ancestor].parent)
+            ancestors[theClass*ancestorWords + ancestor/32] |= 1u << (ancestor%32);
+}
+
+
+/*======================================================================*/
+void freeAncestors(void)
+{
+    if (ancestors != NULL)
+        deallocate(ancestors);
+    ancestors = NULL;
+    ancestorClassMax = 0;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool walkedIsA(int parent, int ancestor)
+{
+    while (parent != 0 && parent != ancestor)
+        parent = classes[parent].parent;
+
+    return (parent != 0);
+}
+
+
 /*======================================================================*/
 bool isA(int instance, int ancestor)
 {
@@ -40,10 +165,12 @@ bool isA(int instance, int ancestor)
         parent = literals[instance-header->instanceMax].class;
     else
         parent = instances[instance].parent;
-    while (parent != 0 && parent != ancestor)
-        parent = classes[parent].parent;
 
-    return (parent != 0);
+    if (ancestors == NULL || walkClassesOption || parent <= 0 || parent > ancestorClassMax)
+        return walkedIsA(parent, ancestor);
+    if (ancestor <= 0 || ancestor > ancestorClassMax)
+        return false;
+    return (ancestors[parent*ancestorWords + ancestor/32] & (1u << (ancestor%32))) != 0;
 }
 
 
@@ -90,17 +217,114 @@ bool isOpaque(int container) {
 }
 
 
+/*======================================================================*/
+ChangeStamp currentChangeStamp(void)
+{
+    return changeStamp;
+}
+
+
+/*======================================================================*/
+bool attributesChangedSince(AttributeBuckets buckets, ChangeStamp stamp)
+{
+    int bucket;
+
+    for (bucket = 0; buckets != 0; bucket++, buckets >>= 1)
+        if ((buckets & 1) && attributeChangeStamps[bucket] > stamp)
+            return true;
+    return false;
+}
+
+
+/*======================================================================*/
+bool locationsChangedSince(ChangeStamp stamp)
+{
+    return locationChangeStamp > stamp;
+}
+
+
+/*======================================================================*/
+void allAttributesChanged(void)
+{
+    int bucket;
+
+    changeStamp++;
+    for (bucket = 0; bucket < ATTRIBUTE_BUCKETS; bucket++)
+        attributeChangeStamps[bucket] = changeStamp;
+
+    if (writtenAttributePages != NULL)
+        memset(writtenAttributePages, 0xff, writtenAttributeWords*sizeof(uint64_t));
+}
+
+
+/*======================================================================*/
+/* Note that the word at the offset in the attribute area was written */
+void attributeWordWritten(int offset)
+{
+    int page = offset/ATTRIBUTE_PAGE_WORDS;
+
+    if (writtenAttributePages != NULL && offset >= 0 && page/PAGES_PER_WORD < writtenAttributeWords)
+        writtenAttributePages[page/PAGES_PER_WORD] |= (uint64_t)1 << (page%PAGES_PER_WORD);
+}
+
+
+/*======================================================================*/
+/* The first page of the attribute area at or after the given one that
+   was written, or -1 if there is none */
+int nextWrittenAttributePage(int page)
+{
+    int word = page/PAGES_PER_WORD;
+    uint64_t pages;
+
+    if (word >= writtenAttributeWords)
+        return -1;
+    pages = writtenAttributePages[word] >> (page%PAGES_PER_WORD);
+    while (pages == 0) {
+        if (++word >= writtenAttributeWords)
+            return -1;
+        page = word*PAGES_PER_WORD;
+        pages = writtenAttributePages[word];
+    }
+    for (; (pages & 1) == 0; pages >>= 1)
+        page++;
+    return page;
+}
+
+
+/*======================================================================*/
+void forgetWrittenAttributes(void)
+{
+    if (writtenAttributePages != NULL)
+        memset(writtenAttributePages, 0, writtenAttributeWords*sizeof(uint64_t));
+}
+
+
+/*----------------------------------------------------------------------*/
+static AttributeEntry *attributeEntryOf(int instance, int attribute)
+{
+    AttributeEntry *entry = attributeOf(instance, attribute);
+
+    if (entry == NULL)
+        syserr("Attribute not found.");
+    return entry;
+}
+
+
 /*======================================================================*/
 void setInstanceAttribute(int instance, int attribute, Aptr value)
 {
     char str[80];
 
     if (instance > 0 && instance <= header->instanceMax) {
-        setAttribute(admin[instance].attributes, attribute, value);
+        AttributeEntry *entry = attributeEntryOf(instance, attribute);
+        entry->value = value;
+        attributeWordWritten((Aword *)&entry->value - (Aword *)attributes);
+        gameStateChanged = true;
+        attributeChangeStamps[attributeBucketOf(attribute)] = ++changeStamp;
         if (isALocation(instance) && attribute != VISITSATTRIBUTE)
             /* If it wasn't the VISITSATTRIBUTE the location may have
                changed so describe next time */
-            admin[instance].visitsCount = 0;
+            admin.visitsCount[instance] = 0;
     } else {
         sprintf(str, "Can't SET/MAKE instance (%d).", instance);
         syserr(str);
@@ -136,7 +360,7 @@ static Aword getLiteralAttribute(int literal, int attribute)
         if (attribute == 0)
             return literals[literalFromInstance(literal)].value;
         else
-            return getAttribute(admin[header->instanceMax].attributes, attribute);
+            return attributeEntryOf(header->instanceMax, attribute)->value;
     }
     return(EOF);
 }
@@ -154,7 +378,7 @@ Aword getInstanceAttribute(int instance, int attribute)
             if (attribute == -1)
                 return locationOf(instance);
             else
-                return getAttribute(admin[instance].attributes, attribute);
+                return attributeEntryOf(instance, attribute)->value;
         } else {
             sprintf(str, "Can't ATTRIBUTE instance %d.", instance);
             syserr(str);
@@ -167,7 +391,7 @@ Aword getInstanceAttribute(int instance, int attribute)
 
 /*======================================================================*/
 bool hasAttribute(Aid instance, Aid attribute) {
-    return attributeExists(admin[instance].attributes, attribute);
+    return attributeOf(instance, attribute) != NULL;
 }
 
 
@@ -249,16 +473,16 @@ bool isIn(int instance, int container, ATrans trans)
         syserr("IN in a non-container.");
 
     if (trans == DIRECT)
-        return admin[instance].location == container;
+        return admin.location[instance] == container;
     else {
-        loc = admin[instance].location;
+        loc = admin.location[instance];
         if (trans == INDIRECT && loc != 0 && !isA(loc, LOCATION))
-            loc = admin[loc].location;
+            loc = admin.location[loc];
         while (loc != 0 && !isA(loc, LOCATION))
             if (loc == container)
                 return true;
             else
-                loc = admin[loc].location;
+                loc = admin.location[loc];
         return false;
     }
 }
@@ -274,20 +498,20 @@ bool isAt(int instance, int other, ATrans trans)
     if (isALocation(instance)) {
         /* Nested locations */
         /* TODO - What if the other is not a location? */
-        int current = admin[instance].location;
+        int current = admin.location[instance];
         switch (trans) {
         case DIRECT:
-            return admin[instance].location == other;
+            return admin.location[instance] == other;
         case INDIRECT:
             if (current == other)
                 return false;
-            current = admin[current].location;
+            current = admin.location[current];
         case TRANSITIVE:
             while (current != 0) {
                 if (current == other)
                     return true;
                 else
-                    current = admin[current].location;
+                    current = admin.location[current];
             }
             return false;
         }
@@ -297,9 +521,9 @@ bool isAt(int instance, int other, ATrans trans)
         /* Instance is not a location but other is */
         switch (trans) {
         case DIRECT:
-            return admin[instance].location == other;
+            return admin.location[instance] == other;
         case INDIRECT: {
-            if (admin[instance].location == other)
+            if (admin.location[instance] == other)
                 return false;   /* Directly, so not Indirectly */
             /* Fall through to transitive handling of the location */
         }
@@ -310,7 +534,7 @@ bool isAt(int instance, int other, ATrans trans)
                 if (current == location)
                     return true;
                 else
-                    current = admin[current].location;
+                    current = admin.location[current];
             }
             return false;
         }
@@ -321,19 +545,19 @@ bool isAt(int instance, int other, ATrans trans)
         /* Other is also not a location */
         switch (trans) {
         case DIRECT:
-            return positionOf(instance) == admin[other].location;
+            return positionOf(instance) == admin.location[other];
         case INDIRECT: {
             int location = locationOf(instance);
             int current = other;
             if (location == current)
                 return false;
             else
-                current = admin[current].location;
+                current = admin.location[current];
             while (current != 0) {
                 if (current == location)
                     return true;
                 else
-                    current = admin[current].location;
+                    current = admin.location[current];
             }
             return false;
         }
@@ -345,7 +569,7 @@ bool isAt(int instance, int other, ATrans trans)
                 if (current == location)
                     ok = true;
                 else
-                    current = admin[current].location;
+                    current = admin.location[current];
             }
             return ok;
         }
@@ -357,23 +581,41 @@ bool isAt(int instance, int other, ATrans trans)
 
 
 /*======================================================================*/
-/* Return the *location* of an instance, transitively, i.e. the first
+void forgetLocationOf(int instance)
+{
+    locationChangeStamp = ++changeStamp;
+    if (instance > 0 && instance <= knownLocationsMax)
+        knownLocations[instance] = UNKNOWN_LOCATION;
+}
+
+
+/*======================================================================*/
+void forgetAllLocations(void)
+{
+    locationChangeStamp = ++changeStamp;
+    if (knownLocations != NULL)
+        deallocate(knownLocations);
+    knownLocations = NULL;
+    knownLocationsMax = 0;
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Find the *location* of an instance, transitively, i.e. the first
    location instance found when traversing the containment/position
    links. If that didn't turn up a location see if it was in a
    container that is somewhere, or a THING that is nowhere. It might
    also be an ENTITY which is always everywhere so take that to mean
    where the hero is. */
-int locationOf(int instance)
+static int findLocationOf(int instance)
 {
     int position;
     int container = 0;
 
-    verifyInstance(instance, "get LOCATION of");
-
-    position = admin[instance].location;
+    position = admin.location[instance];
     while (position != 0 && !isALocation(position)) {
         container = position;   /* Remember innermost container */
-        position = admin[position].location;
+        position = admin.location[position];
     }
     if (position > NOWHERE) /* It was a location so return that */
         return position;
@@ -387,17 +629,43 @@ int locationOf(int instance)
         else if (isALocation(instance))
             return NO_LOCATION; /* No location */
         else
-            return locationOf(HERO);
+            return FOLLOWS_HERO;
     }
 }
 
 
+/*======================================================================*/
+int locationOf(int instance)
+{
+    int location;
+
+    verifyInstance(instance, "get LOCATION of");
+
+    if (knownLocations == NULL) {
+        int i;
+        knownLocationsMax = header->instanceMax;
+        knownLocations = allocate((knownLocationsMax+1)*sizeof(Aint));
+        for (i = 0; i <= knownLocationsMax; i++)
+            knownLocations[i] = UNKNOWN_LOCATION;
+    }
+
+    location = knownLocations[instance];
+    if (location == UNKNOWN_LOCATION) {
+        location = findLocationOf(instance);
+        knownLocations[instance] = location;
+    }
+    if (location == FOLLOWS_HERO)
+        return locationOf(HERO);
+    return location;
+}
+
+
 /*======================================================================*/
 /* Return the current position of an instance, directly or not */
 /* TODO: this will be a possible duplicate of where() */
 int positionOf(int instance)
 {
-    return admin[instance].location;
+    return admin.location[instance];
 }
 
 
@@ -410,7 +678,7 @@ int where(int instance, ATrans trans)
     if (isALocation(instance))
         return 0;
     else if (trans == DIRECT)
-        return admin[instance].location;
+        return admin.location[instance];
     else
         return locationOf(instance);
 }
@@ -497,12 +765,14 @@ void sayString(char *string)
 /*----------------------------------------------------------------------*/
 static void sayLiteral(int literal)
 {
+    char *value;
     char *str;
 
     if (isANumeric(literal))
         sayInteger(literals[literal-header->instanceMax].value);
     else {
-        str = (char *)strdup((char *)fromAptr(literals[literal-header->instanceMax].value));
+        value = (char *)fromAptr(literals[literal-header->instanceMax].value);
+        str = strcpy(allocateTemporary(strlen(value)+1), value);
         sayString(str);
     }
 }
@@ -738,7 +1008,7 @@ void describeAnything(int instance)
         if (instances[instance].parent != 0)
             describeClass(instances[instance].parent);
     }
-    admin[instance].alreadyDescribed = true;
+    admin.alreadyDescribed[instance] = true;
 }
 
 
@@ -753,7 +1023,7 @@ static void describeObject(int object)
         if (instances[object].container != 0)
             describeContainer(object);
     }
-    admin[object].alreadyDescribed = true;
+    admin.alreadyDescribed[object] = true;
 }
 
 
@@ -793,22 +1063,21 @@ void describeInstances(void)
     int found = 0;
 
     /* First describe every object here with its own description */
-    for (i = 1; i <= header->instanceMax; i++)
-        if (admin[i].location == current.location && isAObject(i) &&
-                !admin[i].alreadyDescribed && hasDescription(i))
+    for (i = firstContained(current.location); i != 0; i = nextContained(current.location, i))
+        if (isAObject(i) &&
+                !admin.alreadyDescribed[i] && hasDescription(i))
             describe(i);
 
     /* Then list all things without a description */
-    for (i = 1; i <= header->instanceMax; i++)
-        if (admin[i].location == current.location
-                && !admin[i].alreadyDescribed
+    for (i = firstContained(current.location); i != 0; i = nextContained(current.location, i))
+        if (!admin.alreadyDescribed[i]
                 && isAObject(i)
                 && descriptionCheck(i)) {
             if (found == 0)
                 printMessageWithInstanceParameter(M_SEE_START, i);
             else if (found > 1)
                 printMessageWithInstanceParameter(M_SEE_COMMA, lastInstanceFound);
-            admin[i].alreadyDescribed = true;
+            admin.alreadyDescribed[i] = true;
 
             // TODO : isOpaque()
             if (instances[i].container && containerSize(i, DIRECT) > 0 && !getInstanceAttribute(i, OPAQUEATTRIBUTE)) {
@@ -831,14 +1100,14 @@ void describeInstances(void)
     }
 
     /* Finally all actors with a separate description */
-    for (i = 1; i <= header->instanceMax; i++)
-        if (admin[i].location == current.location && i != HERO && isAActor(i)
-        && !admin[i].alreadyDescribed)
+    for (i = firstContained(current.location); i != 0; i = nextContained(current.location, i))
+        if (i != HERO && isAActor(i)
+        && !admin.alreadyDescribed[i])
             describe(i);
 
     /* Clear the describe flag for all instances */
     for (i = 1; i <= header->instanceMax; i++)
-        admin[i].alreadyDescribed = false;
+        admin.alreadyDescribed[i] = false;
 }
 
 
@@ -870,7 +1139,7 @@ static void locateIntoContainer(Aword theInstance, Aword theContainer) {
     if (!isA(theInstance, containers[instances[theContainer].container].class))
         printMessageUsing2InstanceParameters(M_CANNOTCONTAIN, theContainer, theInstance);
     else if (passesContainerLimits(theContainer, theInstance))
-        admin[theInstance].location = theContainer;
+        setLocationOf(theInstance, theContainer);
     else
         abortPlayerCommand();
 }
@@ -883,12 +1152,12 @@ static void locateLocation(Aword loc, Aword whr)
 
     /* Ensure this does not create a recursive location chain */
     while (l != 0) {
-        if (admin[l].location == loc)
+        if (admin.location[l] == loc)
             apperr("Locating a location that would create a recursive loop of locations containing each other.");
         else
-            l = admin[l].location;
+            l = admin.location[l];
     }
-    admin[loc].location = whr;
+    setLocationOf(loc, whr);
 }
 
 
@@ -898,9 +1167,9 @@ static void locateObject(Aword obj, Aword whr)
     if (isAContainer(whr)) { /* Into a container */
         locateIntoContainer(obj, whr);
     } else {
-        admin[obj].location = whr;
+        setLocationOf(obj, whr);
         /* Make sure the location is described since it's changed */
-        admin[whr].visitsCount = 0;
+        admin.visitsCount[whr] = 0;
     }
 }
 
@@ -937,8 +1206,8 @@ static void executeInheritedEntered(Aint theClass) {
 static void executeEntered(Aint instance) {
     int currentInstance = current.instance;
     current.instance = instance;
-    if (admin[instance].location != 0)
-        executeEntered(admin[instance].location);
+    if (admin.location[instance] != 0)
+        executeEntered(admin.location[instance]);
     executeInheritedEntered(instances[instance].parent);
     if (traceSectionOption)
         traceEnteredInstance(instance, instances[instance].entered == 0);
@@ -958,9 +1227,9 @@ static int getVisits(int location) {
 /*----------------------------------------------------------------------*/
 static void incrementVisits(int location) {
     setInstanceAttribute(location, VISITSATTRIBUTE, getVisits(location)+1);
-    if (admin[location].location != 0)
+    if (admin.location[location] != 0)
         /* Nested location, so increment that too */
-        incrementVisits(admin[location].location);
+        incrementVisits(admin.location[location]);
 }
 
 
@@ -980,10 +1249,10 @@ static void revisited(void) {
 /*----------------------------------------------------------------------*/
 static bool shouldBeDescribed(void) {
     if (!isPreBeta5(header->version))
-        return getVisits(admin[HERO].location) % (current.visits+1) == 0
-            || admin[admin[HERO].location].visitsCount == 0;
+        return getVisits(admin.location[HERO]) % (current.visits+1) == 0
+            || admin.visitsCount[admin.location[HERO]] == 0;
     else
-        return admin[admin[HERO].location].visitsCount % (current.visits+1) == 0;
+        return admin.visitsCount[admin.location[HERO]] % (current.visits+1) == 0;
 }
 
 
@@ -991,7 +1260,7 @@ static bool shouldBeDescribed(void) {
 static void locateActor(Aint movingActor, Aint whr)
 {
     Aint previousCurrentLocation = current.location;
-    Aint previousActorLocation = admin[movingActor].location;
+    Aint previousActorLocation = admin.location[movingActor];
     Aint previousActor = current.actor;
     Aint previousInstance = current.instance;
 
@@ -1007,7 +1276,7 @@ static void locateActor(Aint movingActor, Aint whr)
         locateIntoContainer(movingActor, whr);
     else {
         current.location = whr;
-        admin[movingActor].location = whr;
+        setLocationOf(movingActor, whr);
     }
 
     /* Now we have moved, so show what is needed... */
@@ -1026,10 +1295,10 @@ static void locateActor(Aint movingActor, Aint whr)
             look();
         else
             revisited();
-        admin[where(HERO, DIRECT)].visitsCount++;
+        admin.visitsCount[where(HERO, DIRECT)]++;
     } else
         /* Ensure that the location will be described to the hero next time */
-        admin[whr].visitsCount = 0;
+        admin.visitsCount[whr] = 0;
 
     if (current.actor != movingActor)
         current.location = previousCurrentLocation;
@@ -1050,7 +1319,7 @@ static void traceExtract(int instance, int containerId, char *what) {
 
 /*----------------------------------------------------------------------*/
 static void containmentLoopError(int instance, int whr) {
-    ParameterArray parameters = newParameterArray();
+    ParameterArray parameters = newTemporaryParameterArray();
     if (isPreBeta4(header->version))
         output("That would be to put something inside itself.");
     else if (whr == instance) {
@@ -1061,7 +1330,7 @@ static void containmentLoopError(int instance, int whr) {
         addParameterForInstance(parameters, whr);
         printMessageWithParameters(M_CONTAINMENT_LOOP2, parameters);
     }
-    free(parameters);
+    freeParameterArray(parameters);
     error(NO_MSG);
 }
 
@@ -1106,8 +1375,8 @@ void locate(int instance, int whr)
         containmentLoopError(instance, whr);
 
     /* First check if the instance is in a container, if so run extract checks */
-    if (isAContainer(admin[instance].location)) {    /* In something? */
-        int loc = admin[instance].location;
+    if (isAContainer(admin.location[instance])) {    /* In something? */
+        int loc = admin.location[instance];
 
         /* Run all nested extraction checks */
         while (isAContainer(loc)) {
@@ -1119,7 +1388,7 @@ void locate(int instance, int whr)
                 return;
             }
             runExtractStatements(instance, containerId);
-            loc = admin[loc].location;
+            loc = admin.location[loc];
         }
         current.instance = previousInstance;
     }
@@ -12,10 +12,11 @@
 #include "set.h"
 
 /* Constants: */
+#define ATTRIBUTE_BUCKETS 64
 
 
 /* Types: */
-typedef struct AdminEntry { /* Administrative data about instances */
+typedef struct AdminEntry { /* Administrative data about an instance, as saved */
   Aint location;
   AttributeEntry *attributes;
   Abool alreadyDescribed;
@@ -25,16 +26,48 @@ typedef struct AdminEntry { /* Administrative data about instances */
   Aint waitCount;
 } AdminEntry;
 
+/* The administrative data is kept as one array for each field, indexed
+   by instance, so that loops looking at e.g. only the location of every
+   instance go through consecutive words. */
+typedef struct Admin {
+  Aint *location;
+  AttributeEntry **attributes;
+  Abool *alreadyDescribed;
+  Aint *visitsCount;
+  Aint *script;
+  Aint *step;
+  Aint *waitCount;
+} Admin;
+
+typedef unsigned long ChangeStamp;
+typedef uint64_t AttributeBuckets; /* A bit for every attribute bucket */
+#define attributeBucketOf(attribute) ((unsigned)(attribute) % ATTRIBUTE_BUCKETS)
+#define ATTRIBUTE_PAGE_WORDS 32     /* Words in the attribute area tracked together */
+
 
 /* Data: */
 extern InstanceEntry *instances; /* Instance table pointer */
 
-extern AdminEntry *admin;   /* Administrative data about instances */
+extern Admin admin;         /* Administrative data about instances */
 extern AttributeEntry *attributes; /* Dynamic attribute values */
 
 
 /* Functions: */
+extern void allocateAdmin(void);
+extern void getAdminEntry(int instance, AdminEntry *entry);
+extern void setAdminEntry(int instance, AdminEntry *entry);
+extern void indexAncestors(void);
+extern void freeAncestors(void);
 extern bool isA(int instance, int class);
+extern void forgetLocationOf(int instance);
+extern void forgetAllLocations(void);
+extern ChangeStamp currentChangeStamp(void);
+extern bool attributesChangedSince(AttributeBuckets buckets, ChangeStamp stamp);
+extern bool locationsChangedSince(ChangeStamp stamp);
+extern void allAttributesChanged(void);
+extern void attributeWordWritten(int offset);
+extern int nextWrittenAttributePage(int page);
+extern void forgetWrittenAttributes(void);
 extern bool isAObject(int instance);
 extern bool isAContainer(int instance);
 extern bool isAActor(int instance);
@@ -45,7 +45,7 @@ Ensure(Instance, canAccessLiteralValue) {
 
 static void given_number_of_instances(int count) {
     header->instanceMax = count;
-    admin = allocate((count+1)*sizeof(AdminEntry));
+    admin.location = allocate((count+1)*sizeof(Aint));
     instances = allocate((count+1)*sizeof(InstanceEntry));
 }
 
@@ -61,9 +61,9 @@ Ensure(Instance, stopsLookingInsideContainersWhenEncounteringLocation) {
     instances[3].container = 1;
 
     /* Nest them */
-    admin[1].location = 2;
-    admin[2].location = 3;
-    admin[3].location = 0;
+    admin.location[1] = 2;
+    admin.location[2] = 3;
+    admin.location[3] = 0;
 
     /* Make intermediate into location */
     instances[2].parent = LOCATION;
@@ -4,6 +4,7 @@
 #include "instance.h"
 
 #include "memory.h"
+#include "options.h"
 
 
 /* Mocked modules */
@@ -11,6 +12,7 @@
 #include "class.mock"
 #include "attribute.mock"
 #include "syserr.mock"
+#include "containment.mock"
 #include "compatibility.mock"
 #include "current.mock"
 #include "location.mock"
@@ -56,10 +58,9 @@ static void setup_memory(size_t instance_count) {
 
     header->instanceMax = instance_count;
 
-    int admin_start = classes_start + (class_count+1)*sizeof(ClassEntry)/sizeof(Aword);
-    admin = (AdminEntry*)&memory[admin_start];
+    allocateAdmin();
 
-    int instances_start = admin_start + (instance_count+1)*sizeof(AdminEntry)/sizeof(Aword);
+    int instances_start = classes_start + (class_count+1)*sizeof(ClassEntry)/sizeof(Aword);
     instances = (InstanceEntry*)&memory[instances_start];
 }
 
@@ -76,13 +77,16 @@ BeforeEach(Instance) {
 }
 
 AfterEach(Instance) {
+    forgetAllLocations();
+    freeAncestors();
+    walkClassesOption = false;
     free(memory);
 }
 
 static int given_an_instance_at(char *name, int parent, int location) {
     instance_count++;
     instances[instance_count].parent = parent;
-    admin[instance_count].location = location;
+    admin.location[instance_count] = location;
     return instance_count;
 }
 
@@ -236,3 +240,179 @@ Ensure(Instance, can_see_if_a_location_is_transitive_at_another2) {
 
     assert_that(isAt(inner, outer, TRANSITIVE));
 }
+
+
+static bool walkedIsA(int instance, int class) {
+    bool result;
+
+    walkClassesOption = true;
+    result = isA(instance, class);
+    walkClassesOption = false;
+    return result;
+}
+
+Ensure(Instance, isA_gives_same_result_with_ancestor_index_as_when_walking_classes) {
+    int instance, class;
+
+    given_an_instance_at("thing", THING, 0);
+    given_an_instance_at("object", OBJECT, 0);
+    given_an_instance_at("location", LOCATION, 0);
+    given_an_instance_at("actor", ACTOR, 0);
+    given_an_instance_at("entity", ENTITY, 0);
+
+    indexAncestors();
+
+    for (instance = 1; instance <= instance_count; instance++)
+        for (class = 0; class <= header->classMax+1; class++)
+            assert_that(isA(instance, class), is_equal_to(walkedIsA(instance, class)));
+}
+
+Ensure(Instance, isA_finds_instance_parent_and_its_ancestors_in_ancestor_index) {
+    Aint object = given_an_instance_at("object", OBJECT, 0);
+
+    indexAncestors();
+
+    assert_that(isA(object, OBJECT));
+    assert_that(isA(object, THING));
+    assert_that(isA(object, ENTITY));
+    assert_that(!isA(object, LOCATION));
+    assert_that(!isA(object, 0));
+}
+
+Ensure(Instance, isA_uses_class_of_literals) {
+    LiteralEntry literalTable[2];
+    Aint literal = header->instanceMax+1;
+
+    literalTable[1].class = LOCATION;
+    literals = literalTable;
+
+    indexAncestors();
+
+    assert_that(isA(literal, ENTITY));
+    assert_that(isA(literal, LOCATION));
+    assert_that(!isA(literal, OBJECT));
+}
+
+
+static void given_a_nowhere_location(void) {
+    Aint nowhere = given_an_instance_at("nowhere", LOCATION, 0);
+    assert_that(nowhere, is_equal_to(NOWHERE));
+}
+
+Ensure(Instance, locationOf_finds_location_through_nested_containers) {
+    given_a_nowhere_location();
+    Aint location = given_an_instance_at("location", LOCATION, 0);
+    Aint box = given_a_container_instance_at("box", OBJECT, location);
+    Aint bag = given_a_container_instance_at("bag", OBJECT, box);
+    Aint coin = given_an_instance_at("coin", OBJECT, bag);
+
+    assert_that(locationOf(coin), is_equal_to(location));
+    assert_that(where(coin, TRANSITIVE), is_equal_to(location));
+    assert_that(where(coin, DIRECT), is_equal_to(bag));
+    assert_that(isAt(coin, location, TRANSITIVE));
+}
+
+Ensure(Instance, locationOf_finds_innermost_of_nested_locations) {
+    given_a_nowhere_location();
+    Aint outer = given_an_instance_at("outer", LOCATION, 0);
+    Aint inner = given_an_instance_at("inner", LOCATION, outer);
+    Aint object = given_an_instance_at("object", OBJECT, inner);
+
+    assert_that(locationOf(object), is_equal_to(inner));
+    assert_that(locationOf(inner), is_equal_to(outer));
+    assert_that(isAt(object, inner, TRANSITIVE));
+    assert_that(!isAt(object, outer, DIRECT));
+    assert_that(isAt(inner, outer, TRANSITIVE));
+}
+
+Ensure(Instance, locationOf_keeps_location_until_forgotten) {
+    given_a_nowhere_location();
+    Aint first = given_an_instance_at("first", LOCATION, 0);
+    Aint second = given_an_instance_at("second", LOCATION, 0);
+    Aint box = given_a_container_instance_at("box", OBJECT, first);
+    Aint coin = given_an_instance_at("coin", OBJECT, box);
+
+    assert_that(locationOf(coin), is_equal_to(first));
+
+    admin.location[box] = second;
+    assert_that(locationOf(coin), is_equal_to(first));
+
+    forgetLocationOf(box);
+    forgetLocationOf(coin);
+    assert_that(locationOf(box), is_equal_to(second));
+    assert_that(locationOf(coin), is_equal_to(second));
+    assert_that(isAt(coin, second, TRANSITIVE));
+    assert_that(!isAt(coin, first, TRANSITIVE));
+}
+
+Ensure(Instance, locationOf_of_moved_nested_location_changes_for_contents) {
+    given_a_nowhere_location();
+    Aint first = given_an_instance_at("first", LOCATION, 0);
+    Aint second = given_an_instance_at("second", LOCATION, 0);
+    Aint room = given_an_instance_at("room", LOCATION, first);
+    Aint object = given_an_instance_at("object", OBJECT, room);
+
+    assert_that(locationOf(room), is_equal_to(first));
+
+    admin.location[room] = second;
+    forgetLocationOf(room);
+    forgetLocationOf(object);
+
+    assert_that(locationOf(object), is_equal_to(room));
+    assert_that(locationOf(room), is_equal_to(second));
+    assert_that(isAt(room, second, TRANSITIVE));
+    assert_that(!isAt(room, first, TRANSITIVE));
+}
+
+Ensure(Instance, locationOf_returns_nowhere_for_thing_in_container_not_anywhere) {
+    given_a_nowhere_location();
+    Aint box = given_a_container_instance_at("box", OBJECT, 0);
+    Aint coin = given_an_instance_at("coin", OBJECT, box);
+    Aint thing = given_an_instance_at("thing", THING, NOWHERE);
+
+    assert_that(locationOf(coin), is_equal_to(NOWHERE));
+    assert_that(locationOf(thing), is_equal_to(NOWHERE));
+}
+
+Ensure(Instance, locationOf_returns_no_location_for_location_not_anywhere) {
+    given_a_nowhere_location();
+    Aint location = given_an_instance_at("location", LOCATION, 0);
+
+    assert_that(locationOf(location), is_equal_to(NO_LOCATION));
+}
+
+Ensure(Instance, locationOf_lets_entity_follow_the_hero) {
+    given_a_nowhere_location();
+    Aint first = given_an_instance_at("first", LOCATION, 0);
+    Aint second = given_an_instance_at("second", LOCATION, 0);
+    header->theHero = given_an_instance_at("hero", ACTOR, first);
+    Aint entity = given_an_instance_at("entity", ENTITY, 0);
+
+    assert_that(locationOf(entity), is_equal_to(first));
+
+    admin.location[HERO] = second;
+    forgetLocationOf(HERO);
+
+    assert_that(locationOf(entity), is_equal_to(second));
+}
+
+Ensure(Instance, locations_have_changed_after_a_location_is_forgotten) {
+    ChangeStamp stamp = currentChangeStamp();
+
+    assert_that(locationsChangedSince(stamp), is_false);
+    forgetLocationOf(1);
+    assert_that(locationsChangedSince(stamp), is_true);
+}
+
+Ensure(Instance, attributes_have_changed_in_all_buckets_after_all_have_changed) {
+    ChangeStamp stamp = currentChangeStamp();
+    AttributeBuckets first = (AttributeBuckets)1 << attributeBucketOf(1);
+    AttributeBuckets last = (AttributeBuckets)1 << attributeBucketOf(ATTRIBUTE_BUCKETS-1);
+
+    assert_that(attributesChangedSince(first|last, stamp), is_false);
+    allAttributesChanged();
+    assert_that(attributesChangedSince(first, stamp), is_true);
+    assert_that(attributesChangedSince(last, stamp), is_true);
+    assert_that(locationsChangedSince(stamp), is_false);
+    assert_that(attributesChangedSince(0, stamp), is_false);
+}
@@ -25,6 +25,9 @@ Interpreter unit for Alan interpreter Arun
 #include "Container.h"
 #include "Location.h"
 #include "compatibility.h"
+#include "branches.h"
+#include "profile.h"
+#include "predecode.h"
 
 #ifdef HAVE_GLK
 #define MAP_STDIO_TO_GLK
@@ -34,6 +37,7 @@ Interpreter unit for Alan interpreter Arun
 
 bool stopAtNextLine = false;
 bool fail = false;
+ReadSet *readSet = NULL;
 
 
 /* PRIVATE DATA */
@@ -263,6 +267,22 @@ static void traceSkip() {
     }
 }
 
+/*----------------------------------------------------------------------*/
+static bool jumpedToBranchTarget(void) {
+    /* If the instruction we just fetched has a precomputed target, go
+       there. When tracing we do the scanning to show the same output. */
+    Aaddr target;
+
+    if (traceInstructionOption)
+        return false;
+
+    target = branchTarget(pc-1);
+    if (target == 0)
+        return false;
+    pc = target;
+    return true;
+}
+
 /*----------------------------------------------------------------------*/
 static void interpretIf(Aword v)
 {
@@ -272,6 +292,8 @@ static void interpretIf(Aword v)
     if (!v) {
         /* Skip to next ELSE or ENDIF on same level */
         traceSkip();
+        if (jumpedToBranchTarget())
+            return;
         while (true) {
             i = memory[pc++];
             if (I_CLASS(i) == (Aword)C_STMOP)
@@ -307,6 +329,8 @@ static void interpretElse(void)
     Aword i;
 
     traceSkip();
+    if (jumpedToBranchTarget())
+        return;
     while (true) {
         /* Skip to ENDIF on the same level */
         i = memory[pc++];
@@ -330,6 +354,8 @@ static void goToLOOPEND(void) {
     int i;
 
     traceSkip();
+    if (jumpedToBranchTarget())
+        return;
     while (true) {
         /* Skip past LOOPEND on the same level */
         i = memory[pc];
@@ -355,6 +381,8 @@ static void jumpBackToStartOfMatchingLOOP(void) {
     int i;
 
     traceSkip();
+    if (jumpedToBranchTarget())
+        return;
     pc--;				/* Ignore the instruction we're on */
     while (true) {
         /* Skip back past LOOP on the same level */
@@ -415,6 +443,8 @@ static void depexec(Aword v)
         /* The expression was not true, skip to next CASE on the same
            level which could be a DEPCASE or DEPELSE */
         if (traceInstructionOption) printf("\n    : ");
+        if (jumpedToBranchTarget())
+            return;
         while (true) {
             i = memory[pc++];
             if (I_CLASS(i) == (Aword)C_STMOP)
@@ -459,6 +489,8 @@ static void depcase(void)
     */
 
     if (traceInstructionOption) printf("\n    : ");
+    if (jumpedToBranchTarget())
+        return;
     while (true) {
         i = memory[pc++];
         if (I_CLASS(i) == (Aword)C_STMOP)
@@ -597,32 +629,98 @@ static bool stillOnSameLine(Aint line, Aint file) {
     return line != current.sourceLine || file != current.sourceFile;
 }
 
-/*======================================================================*/
-void interpret(Aaddr adr)
-{
-    Aaddr oldpc;
-    Aword i;
-
-    /* Check for mock implementation */
-    if (interpreterMock != NULL) {
-        interpreterMock(adr);
-        return;
+/*----------------------------------------------------------------------*/
+/* Record what the instruction about to be executed reads, the
+   attribute code is on top of the stack for the attribute reads */
+static void recordRead(Aword instruction) {
+    switch (I_CLASS(instruction)) {
+    case C_CONST:
+        break;
+    case C_CURVAR:
+        switch (I_OP(instruction)) {
+        case V_MAX_INSTANCE:
+            break;
+        case V_PARAM:
+            readSet->untracked = true;
+            break;
+        default:
+            readSet->current = true;
+            break;
+        }
+        break;
+    case C_STMOP:
+        switch (I_OP(instruction)) {
+        case I_ATTRIBUTE:
+        case I_ATTRSTR:
+        case I_ATTRSET:
+            if ((Aint)top(stack) == -1) /* The location */
+                readSet->locations = true;
+            else
+                readSet->attributes |= (AttributeBuckets)1 << attributeBucketOf(top(stack));
+            break;
+        case I_HERE:
+        case I_NEARBY:
+            readSet->current = true;
+            readSet->locations = true;
+            break;
+        case I_WHERE:
+        case I_LOCATION:
+        case I_NEAR:
+        case I_AT:
+        case I_IN:
+        case I_CONTSIZE:
+        case I_CONTMEMB:
+            readSet->locations = true;
+            break;
+        case I_LINE:
+            if (breakpointCount > 0 || stopAtNextLine)
+                readSet->untracked = true;
+            break;
+        case I_DUP: case I_DUPSTR: case I_POP: case I_GETSTR:
+        case I_NEWSET: case I_UNION: case I_INCLUDE: case I_EXCLUDE:
+        case I_SETSIZE: case I_SETMEMB: case I_INSET: case I_ISA:
+        case I_IF: case I_ELSE: case I_ENDIF:
+        case I_AND: case I_OR: case I_NOT:
+        case I_EQ: case I_NE: case I_STREQ: case I_STREXACT:
+        case I_LE: case I_GE: case I_LT: case I_GT:
+        case I_PLUS: case I_MINUS: case I_MULT: case I_DIV: case I_UMINUS:
+        case I_INCR: case I_DECR: case I_BTW:
+        case I_CONCAT: case I_CONTAINS:
+        case I_MIN: case I_SUM: case I_MAX: case I_COUNT:
+        case I_DEPEND: case I_DEPCASE: case I_DEPEXEC: case I_DEPELSE: case I_ENDDEP:
+        case I_FRAME: case I_GETLOCAL: case I_SETLOCAL: case I_ENDFRAME:
+        case I_LOOP: case I_LOOPNEXT: case I_LOOPEND:
+        case I_RETURN:
+            break;
+        default:
+            readSet->untracked = true;
+            break;
+        }
+        break;
+    default:
+        readSet->untracked = true;
+        break;
     }
+}
 
-    /* Sanity checks: */
-    if (adr == 0) syserr("Interpreting at address 0.");
-    checkForRecursion(adr);
 
-    if (traceInstructionOption)
-        printf("\n++++++++++++++++++++++++++++++++++++++++++++++++++");
+/*----------------------------------------------------------------------*/
+/* Interpret the Acode from pc until a RETURN or a fail, or only the
+   instruction at pc if 'step' is true. Returns true if the code has
+   returned, with the pc restored. */
+static bool interpretAcode(Aaddr oldpc, bool step)
+{
+    Aword i;
 
-    oldpc = pc;
-    pc = adr;
     while(true) {
         if (pc > memTop)
             syserr("Interpreting outside program.");
 
         i = memory[pc++];
+        if (profileOption)
+            profileInstruction(pc-1, i);
+        if (readSet != NULL)
+            recordRead(i);
 
         switch (I_CLASS(i)) {
         case C_CONST:
@@ -709,6 +807,8 @@ void interpret(Aaddr adr)
                 if (traceStackOption)
                     traceStack(stack);
                 skipStackDump = true;
+                if (profileOption)
+                    profileLine(file, line);
                 if (line != 0) {
                     bool atNext = stopAtNextLine && line != current.sourceLine;
                     bool atBreakpoint =  breakpointIndex(file, line) != -1;
@@ -1481,10 +1581,452 @@ void interpret(Aaddr adr)
             syserr("Unknown instruction class.");
             break;
         }
+        if (step)
+            return false;
     }
  exitInterpreter:
-    recursionDepth--;
+    return true;
+}
+
+/*----------------------------------------------------------------------*/
+static bool canInterpretDecoded(void) {
+    return decodedInstructions != NULL && readSet == NULL && !debugOption && !profileOption
+        && !traceSectionOption && !traceSourceOption && !traceInstructionOption
+        && !tracePushOption && !traceStackOption;
+}
+
+
+/* Dispatching of decoded instructions, threaded using computed gotos
+   where the compiler supports it, otherwise a switch in a loop */
+#if defined(__GNUC__) && !defined(NO_THREADED_CODE)
+#define THREADED_CODE
+#endif
+
+#ifdef THREADED_CODE
+#define CASE(opcode) opcode##_LABEL:
+#define DISPATCH() do {                                         \
+        decoded = &decodedInstructions[pc];                     \
+        pc = decoded->next;                                     \
+        folded = decoded->operands;                             \
+        goto *dispatchTable[decoded->opcode];                   \
+    } while (0)
+#else
+#define CASE(opcode) case opcode:
+#define DISPATCH() continue
+#endif
+
+/* Continue after a statement, unless it failed (not wrapped in a
+   do-while since DISPATCH() may be a continue) */
+#define NEXT()                                                  \
+    if (fail) {                                                 \
+        pc = oldpc;                                             \
+        return true;                                            \
+    } else                                                      \
+        DISPATCH()
+
+/* Operands are the folded constants, last pushed first, then the stack */
+#define OPERAND() (folded > 0 ? decoded->operand[--folded] : pop(stack))
+
+/* Branch as a false IF, to the precomputed target if there is one */
+#define BRANCH() do {                                           \
+        if (decoded->target != 0)                               \
+            pc = decoded->target;                               \
+        else                                                    \
+            interpretIf(false);                                 \
+    } while (0)
+
+/* Push the result of a test, or branch on it if followed by an IF */
+#define TEST_RESULT(value) do {                                 \
+        Aword result = (value);                                 \
+        if (!decoded->thenIf)                                   \
+            push(stack, result);                                \
+        else if (!result)                                       \
+            BRANCH();                                           \
+    } while (0)
+
+
+/*----------------------------------------------------------------------*/
+/* Interpret the decoded instructions from pc, like interpretAcode().
+   Returns false if the Acode interpreter has to continue, because
+   tracing or debugging was turned on. */
+static bool interpretDecoded(Aaddr oldpc)
+{
+    DecodedInstruction *decoded;
+    int folded;
+
+#ifdef THREADED_CODE
+    static void *dispatchTable[DECODED_OPCODES] = {
+        [D_OTHER] = &&D_OTHER_LABEL, [D_OUTSIDE] = &&D_OUTSIDE_LABEL,
+        [D_PUSH] = &&D_PUSH_LABEL,
+        [D_PARAM] = &&D_PARAM_LABEL, [D_CURLOC] = &&D_CURLOC_LABEL,
+        [D_CURACT] = &&D_CURACT_LABEL, [D_CURVRB] = &&D_CURVRB_LABEL,
+        [D_CURINS] = &&D_CURINS_LABEL, [D_CURSCORE] = &&D_CURSCORE_LABEL,
+        [D_MAXINSTANCE] = &&D_MAXINSTANCE_LABEL,
+        [D_PRINT] = &&D_PRINT_LABEL, [D_SAY] = &&D_SAY_LABEL,
+        [D_SAYINT] = &&D_SAYINT_LABEL, [D_DESCRIBE] = &&D_DESCRIBE_LABEL,
+        [D_ATTRIBUTE] = &&D_ATTRIBUTE_LABEL, [D_ATTRSTR] = &&D_ATTRSTR_LABEL,
+        [D_MAKE] = &&D_MAKE_LABEL, [D_SET] = &&D_SET_LABEL,
+        [D_LOCATE] = &&D_LOCATE_LABEL, [D_WHERE] = &&D_WHERE_LABEL,
+        [D_LOCATION] = &&D_LOCATION_LABEL, [D_HERE] = &&D_HERE_LABEL,
+        [D_NEARBY] = &&D_NEARBY_LABEL, [D_AT] = &&D_AT_LABEL,
+        [D_IN] = &&D_IN_LABEL, [D_ISA] = &&D_ISA_LABEL,
+        [D_SCHEDULE] = &&D_SCHEDULE_LABEL, [D_CANCEL] = &&D_CANCEL_LABEL,
+        [D_IF] = &&D_IF_LABEL, [D_ELSE] = &&D_ELSE_LABEL,
+        [D_ENDIF] = &&D_ENDIF_LABEL,
+        [D_AND] = &&D_AND_LABEL, [D_OR] = &&D_OR_LABEL, [D_NOT] = &&D_NOT_LABEL,
+        [D_EQ] = &&D_EQ_LABEL, [D_NE] = &&D_NE_LABEL,
+        [D_LT] = &&D_LT_LABEL, [D_GT] = &&D_GT_LABEL,
+        [D_LE] = &&D_LE_LABEL, [D_GE] = &&D_GE_LABEL,
+        [D_PLUS] = &&D_PLUS_LABEL, [D_MINUS] = &&D_MINUS_LABEL,
+        [D_INCR] = &&D_INCR_LABEL, [D_DECR] = &&D_DECR_LABEL,
+        [D_DEPEND] = &&D_DEPEND_LABEL, [D_DEPCASE] = &&D_DEPCASE_LABEL,
+        [D_DEPEXEC] = &&D_DEPEXEC_LABEL, [D_DEPELSE] = &&D_DEPELSE_LABEL,
+        [D_ENDDEP] = &&D_ENDDEP_LABEL,
+        [D_FRAME] = &&D_FRAME_LABEL, [D_GETLOCAL] = &&D_GETLOCAL_LABEL,
+        [D_SETLOCAL] = &&D_SETLOCAL_LABEL, [D_ENDFRAME] = &&D_ENDFRAME_LABEL,
+        [D_LOOP] = &&D_LOOP_LABEL, [D_LOOPNEXT] = &&D_LOOPNEXT_LABEL,
+        [D_LOOPEND] = &&D_LOOPEND_LABEL,
+        [D_DUP] = &&D_DUP_LABEL, [D_POP] = &&D_POP_LABEL,
+        [D_RETURN] = &&D_RETURN_LABEL
+    };
+
+    DISPATCH();
+#else
+    while (true) {
+        decoded = &decodedInstructions[pc];
+        pc = decoded->next;
+        folded = decoded->operands;
+        switch (decoded->opcode) {
+#endif
+
+        CASE(D_OTHER)
+            if (interpretAcode(oldpc, true))
+                return true;
+            if (!canInterpretDecoded())
+                return false;
+            DISPATCH();
+
+        CASE(D_OUTSIDE)
+            syserr("Interpreting outside program.");
+            DISPATCH();
 
+        CASE(D_PUSH)
+            push(stack, decoded->operand[0]);
+            DISPATCH();
+
+        CASE(D_PARAM) {
+            Aint parameter = OPERAND();
+            push(stack, globalParameters[parameter-1].instance);
+            DISPATCH();
+        }
+        CASE(D_CURLOC)
+            push(stack, current.location);
+            DISPATCH();
+        CASE(D_CURACT)
+            push(stack, current.actor);
+            DISPATCH();
+        CASE(D_CURVRB)
+            push(stack, current.verb);
+            DISPATCH();
+        CASE(D_CURINS)
+            push(stack, current.instance);
+            DISPATCH();
+        CASE(D_CURSCORE)
+            push(stack, current.score);
+            DISPATCH();
+        CASE(D_MAXINSTANCE)
+            push(stack, isPreBeta3(header->version)?header->instanceMax:header->instanceMax-1);
+            DISPATCH();
+
+        CASE(D_PRINT) {
+            Aint fpos = OPERAND();
+            Aint len = OPERAND();
+            print(fpos, len);
+            NEXT();
+        }
+        CASE(D_SAY) {
+            Aint form = OPERAND();
+            Aid id = OPERAND();
+            if (form == SAY_SIMPLE)
+                say(id);
+            else
+                sayForm(id, form);
+            NEXT();
+        }
+        CASE(D_SAYINT)
+            sayInteger(OPERAND());
+            NEXT();
+        CASE(D_DESCRIBE)
+            describe(OPERAND());
+            NEXT();
+
+        CASE(D_ATTRIBUTE) {
+            Aint atr = OPERAND();
+            Aid id = OPERAND();
+            TEST_RESULT(getInstanceAttribute(id, atr));
+            NEXT();
+        }
+        CASE(D_ATTRSTR) {
+            Aint atr = OPERAND();
+            Aid id = OPERAND();
+            push(stack, toAptr(getInstanceStringAttribute(id, atr)));
+            NEXT();
+        }
+        CASE(D_MAKE)
+        CASE(D_SET) {
+            Aint atr = OPERAND();
+            Aid id = OPERAND();
+            Aptr val = OPERAND();
+            setInstanceAttribute(id, atr, val);
+            NEXT();
+        }
+
+        CASE(D_LOCATE) {
+            Aid id = OPERAND();
+            Aint whr = OPERAND();
+            locate(id, whr);
+            NEXT();
+        }
+        CASE(D_WHERE) {
+            Abool transitivity = OPERAND();
+            Aid id = OPERAND();
+            push(stack, where(id, transitivity));
+            NEXT();
+        }
+        CASE(D_LOCATION)
+            push(stack, locationOf(OPERAND()));
+            NEXT();
+        CASE(D_HERE) {
+            Abool transitivity = OPERAND();
+            Aid id = OPERAND();
+            TEST_RESULT(isHere(id, transitivity));
+            NEXT();
+        }
+        CASE(D_NEARBY) {
+            Abool transitivity = OPERAND();
+            Aid id = OPERAND();
+            TEST_RESULT(isNearby(id, transitivity));
+            NEXT();
+        }
+        CASE(D_AT) {
+            Abool transitivity = OPERAND();
+            Aint other = OPERAND();
+            Aint instance = OPERAND();
+            TEST_RESULT(isAt(instance, other, transitivity));
+            NEXT();
+        }
+        CASE(D_IN) {
+            Abool transitivity = OPERAND();
+            Aint cnt = OPERAND();
+            Aint obj = OPERAND();
+            TEST_RESULT(isIn(obj, cnt, transitivity));
+            NEXT();
+        }
+        CASE(D_ISA) {
+            Aid rh = OPERAND();
+            Aid lh = OPERAND();
+            TEST_RESULT(isA(lh, rh));
+            NEXT();
+        }
+
+        CASE(D_SCHEDULE) {
+            Aint event = OPERAND();
+            Aint where = OPERAND();
+            Aint after = OPERAND();
+            schedule(event, where, after);
+            NEXT();
+        }
+        CASE(D_CANCEL)
+            cancelEvent(OPERAND());
+            NEXT();
+
+        CASE(D_IF)
+            if (!OPERAND())
+                BRANCH();
+            NEXT();
+        CASE(D_ELSE)
+            if (decoded->target != 0)
+                pc = decoded->target;
+            else
+                interpretElse();
+            NEXT();
+        CASE(D_ENDIF)
+            NEXT();
+
+        CASE(D_AND) {
+            Aword rh = OPERAND();
+            Aword lh = OPERAND();
+            TEST_RESULT(lh && rh);
+            NEXT();
+        }
+        CASE(D_OR) {
+            Aword rh = OPERAND();
+            Aword lh = OPERAND();
+            TEST_RESULT(lh || rh);
+            NEXT();
+        }
+        CASE(D_NOT)
+            TEST_RESULT(!OPERAND());
+            NEXT();
+        CASE(D_EQ) {
+            Aword rh = OPERAND();
+            Aword lh = OPERAND();
+            TEST_RESULT(lh == rh);
+            NEXT();
+        }
+        CASE(D_NE) {
+            Aword rh = OPERAND();
+            Aword lh = OPERAND();
+            TEST_RESULT(lh != rh);
+            NEXT();
+        }
+        CASE(D_LT) {
+            Aint rh = OPERAND();
+            Aint lh = OPERAND();
+            TEST_RESULT(lh < rh);
+            NEXT();
+        }
+        CASE(D_GT) {
+            Aint rh = OPERAND();
+            Aint lh = OPERAND();
+            TEST_RESULT(lh > rh);
+            NEXT();
+        }
+        CASE(D_LE) {
+            Aint rh = OPERAND();
+            Aint lh = OPERAND();
+            TEST_RESULT(lh <= rh);
+            NEXT();
+        }
+        CASE(D_GE) {
+            Aint rh = OPERAND();
+            Aint lh = OPERAND();
+            TEST_RESULT(lh >= rh);
+            NEXT();
+        }
+
+        CASE(D_PLUS) {
+            Aint rh = OPERAND();
+            Aint lh = OPERAND();
+            push(stack, lh + rh);
+            NEXT();
+        }
+        CASE(D_MINUS) {
+            Aint rh = OPERAND();
+            Aint lh = OPERAND();
+            push(stack, lh - rh);
+            NEXT();
+        }
+        CASE(D_INCR) {
+            Aint step = OPERAND();
+            push(stack, OPERAND() + step);
+            NEXT();
+        }
+        CASE(D_DECR) {
+            Aint step = OPERAND();
+            push(stack, OPERAND() - step);
+            NEXT();
+        }
+
+        CASE(D_DEPEND)
+            NEXT();
+        CASE(D_DEPCASE)
+        CASE(D_DEPELSE)
+            depcase();
+            NEXT();
+        CASE(D_DEPEXEC)
+            depexec(OPERAND());
+            NEXT();
+        CASE(D_ENDDEP)
+            pop(stack);
+            NEXT();
+
+        CASE(D_FRAME)
+            newFrame(stack, OPERAND());
+            NEXT();
+        CASE(D_GETLOCAL) {
+            Aint framesBelow = OPERAND();
+            Aint variableNumber = OPERAND();
+            push(stack, getLocal(stack, framesBelow, variableNumber));
+            NEXT();
+        }
+        CASE(D_SETLOCAL) {
+            Aint framesBelow = OPERAND();
+            Aint variableNumber = OPERAND();
+            Aint value = OPERAND();
+            setLocal(stack, framesBelow, variableNumber, value);
+            NEXT();
+        }
+        CASE(D_ENDFRAME)
+            endFrame(stack);
+            NEXT();
+
+        CASE(D_LOOP) {
+            Aint index = OPERAND();
+            Aint limit = OPERAND();
+            push(stack, limit);
+            push(stack, index);
+            if (index > limit)
+                goToLOOPEND();
+            NEXT();
+        }
+        CASE(D_LOOPNEXT)
+            nextLoop();
+            NEXT();
+        CASE(D_LOOPEND) {
+            Aint index = OPERAND();
+            Aint limit = OPERAND();
+            endLoop(index, limit);
+            NEXT();
+        }
+
+        CASE(D_DUP)
+            stackDup();
+            NEXT();
+        CASE(D_POP)
+            (void)OPERAND();
+            NEXT();
+        CASE(D_RETURN)
+            pc = oldpc;
+            return true;
+
+#ifndef THREADED_CODE
+        default:
+            syserr("Unknown decoded instruction.");
+        }
+    }
+#endif
+    return true;
+}
+
+/*======================================================================*/
+void interpret(Aaddr adr)
+{
+    Aaddr oldpc;
+
+    /* Check for mock implementation */
+    if (interpreterMock != NULL) {
+        interpreterMock(adr);
+        return;
+    }
+
+    /* Sanity checks: */
+    if (adr == 0) syserr("Interpreting at address 0.");
+    checkForRecursion(adr);
+    if (profileOption)
+        profileEnter(recursionDepth);
+
+    if (traceInstructionOption)
+        printf("\n++++++++++++++++++++++++++++++++++++++++++++++++++");
+
+    oldpc = pc;
+    pc = adr;
+    if (!canInterpretDecoded() || !interpretDecoded(oldpc))
+        interpretAcode(oldpc, false);
+
+    if (profileOption)
+        profileExit(recursionDepth);
+    recursionDepth--;
 }
 
 /*======================================================================*/
@@ -10,9 +10,18 @@
 
 #include "types.h"
 #include "stack.h"
+#include "instance.h"
 
 /* TYPES: */
 
+/* What an evaluation read of the game state */
+typedef struct ReadSet {
+    bool untracked;             /* Something not tracked below, or random */
+    bool current;               /* Current location, actor, verb... */
+    bool locations;             /* Locations or containment */
+    AttributeBuckets attributes;
+} ReadSet;
+
 
 /* DATA: */
 
@@ -23,6 +32,9 @@ extern int recursionDepth;
 /* Global failure flag */
 extern bool fail;
 
+/* Where to record what is read, if not NULL */
+extern ReadSet *readSet;
+
 
 /* FUNCTIONS: */
 
@@ -37,6 +37,14 @@
 #include "current.h"
 #include "literal.h"
 #include "compatibility.h"
+#include "branches.h"
+#include "predecode.h"
+#include "containment.h"
+#include "attribute.h"
+#include "profile.h"
+#include "AltInfo.h"
+#include "image.h"
+#include "replay.h"
 
 #include "alan.version.h"
 
@@ -113,29 +121,26 @@ static char *eventName(int event) {
 /*----------------------------------------------------------------------*/
 static void runPendingEvents(Stack theStack)
 {
-    int i;
+    EventQueueEntry due;
 
     resetRules();
-    while (eventQueueTop != 0 && eventQueue[eventQueueTop-1].after == 0) {
-        eventQueueTop--;
-        if (isALocation(eventQueue[eventQueueTop].where))
-            current.location = eventQueue[eventQueueTop].where;
+    while (nextDueEvent(&due)) {
+        if (isALocation(due.where))
+            current.location = due.where;
         else
-            current.location = where(eventQueue[eventQueueTop].where, TRANSITIVE);
+            current.location = where(due.where, TRANSITIVE);
         if (traceSectionOption) {
-            printf("\n<EVENT %s[%d] (at ", eventName(eventQueue[eventQueueTop].event),
-                   eventQueue[eventQueueTop].event);
+            printf("\n<EVENT %s[%d] (at ", eventName(due.event), due.event);
             traceSay(current.location);
             printf(" [%d]):>\n", current.location);
         }
-        interpret(events[eventQueue[eventQueueTop].event].code);
+        interpret(events[due.event].code);
         if (stackDepth(theStack) != 0)
             syserr("Stack is not empty after event execution");
         evaluateRules(rules);
     }
 
-    for (i = 0; i<eventQueueTop; i++)
-        eventQueue[i].after--;
+    advanceEventTime();
 }
 
 
@@ -210,7 +215,8 @@ static void setupHeader(ACodeHeader tmphdr) {
 
 
 /*----------------------------------------------------------------------*/
-static void loadAndCheckMemory(ACodeHeader tmphdr, Aword crc, char err[]) {
+/* Load the memory, true if its checksum was right */
+static bool loadAndCheckMemory(ACodeHeader tmphdr, Aword crc, char err[]) {
     int i;
     /* No memory allocated yet? */
     if (memory == NULL) {
@@ -239,7 +245,9 @@ static void loadAndCheckMemory(ACodeHeader tmphdr, Aword crc, char err[]) {
         else {
             printf("%s%s%s", "<WARNING! ", err, " - Ignored, proceed at your own risk.>\n");
         }
+        return false;
     }
+    return true;
 }
 
 
@@ -408,11 +416,19 @@ static void load(void)
     if (tmphdr.size <= sizeof(ACodeHeader)/sizeof(Aword))
         syserr("Malformed game file. Too small.");
 
-    loadAndCheckMemory(tmphdr, crc, err);
-
-    reverseMemory();
+    if (!imageOption || !loadImage(&tmphdr)) {
+        bool checksumOk = loadAndCheckMemory(tmphdr, crc, err);
+        reverseMemory();
+        /* An image would skip the checksum, so never make one of a
+           broken game run with -ignore */
+        if (imageOption && checksumOk)
+            saveImage(&tmphdr);
+    }
     setupHeader(tmphdr);
 
+    indexBranchTargets();
+    predecodeInstructions();
+    clearAlternativeCache();
 }
 
 
@@ -445,6 +461,7 @@ static void initStaticData(void)
     dictionary = (DictionaryEntry *) pointerTo(header->dictionary);
     /* Find out number of entries in dictionary */
     for (dictionarySize = 0; !isEndOfArray(&dictionary[dictionarySize]); dictionarySize++);
+    indexDictionary();
 
     /* All addresses to tables indexed by ids are converted to
        pointers, then adjusted to point to the (imaginary) element
@@ -462,6 +479,7 @@ static void initStaticData(void)
         syserr("Class table pointer == 0");
     classes = (ClassEntry *) pointerTo(header->classTableAddress);
     classes--;			/* Back up one so that first is no. 1 */
+    indexAncestors();
 
     if (header->containerTableAddress != 0) {
         containers = (ContainerEntry *) pointerTo(header->containerTableAddress);
@@ -532,7 +550,7 @@ static AttributeEntry *initializeAttributes(int awordSize)
 
     for (i=1; i<=header->instanceMax; i++) {
         AttributeHeaderEntry *originalAttribute = pointerTo(instances[i].initialAttributes);
-        admin[i].attributes = (AttributeEntry *)currentAttributeArea;
+        admin.attributes[i] = (AttributeEntry *)currentAttributeArea;
         while (!isEndOfArray(originalAttribute)) {
             ((AttributeEntry *)currentAttributeArea)->code = originalAttribute->code;
             ((AttributeEntry *)currentAttributeArea)->value = originalAttribute->value;
@@ -556,10 +574,11 @@ static void initDynamicData(void)
     int instanceId;
 
     /* Allocate for administrative table */
-    admin = (AdminEntry *)allocate((header->instanceMax+1)*sizeof(AdminEntry));
+    allocateAdmin();
 
     /* Create game state copy of attributes */
     attributes = initializeAttributes(sizeOfAttributeData());
+    indexAttributes();
 
     /* Initialise string & set attributes */
     initStrings();
@@ -567,7 +586,8 @@ static void initDynamicData(void)
 
     /* Set initial locations */
     for (instanceId = 1; instanceId <= header->instanceMax; instanceId++)
-        admin[instanceId].location = instances[instanceId].initialLocation;
+        admin.location[instanceId] = instances[instanceId].initialLocation;
+    indexContainment();
 }
 
 
@@ -653,7 +673,13 @@ static void openFiles(void)
         strcat(str, "'.");
         apperr(str);
     }
+    loadText(textFile);
+}
 
+
+/*----------------------------------------------------------------------*/
+static void openLogFiles(void)
+{
     /* If logging open transcript and/or log file */
     if (transcriptOption) {
         startTranscript();
@@ -670,9 +696,11 @@ static void init(Stack theStack)
     int i;
 
     /* Initialise some status */
-    eventQueueTop = 0;			/* No pending events */
+    clearEvents();			/* No pending events */
     initStaticData();
     initDynamicData();
+    if (profileOption)
+        initProfile();
     initParsing();
     checkDebug();
 
@@ -744,47 +772,47 @@ static void moveActor(int theActor)
             capitalize = true;
             fail = false;			/* fail only aborts one actor */
         }
-    } else if (admin[theActor].script != 0) {
+    } else if (admin.script[theActor] != 0) {
         for (scr = (ScriptEntry *) pointerTo(header->scriptTableAddress); !isEndOfArray(scr); scr++) {
-            if (scr->code == admin[theActor].script) {
+            if (scr->code == admin.script[theActor]) {
                 /* Find correct step in the list by indexing */
                 step = (StepEntry *) pointerTo(scr->steps);
-                step = (StepEntry *) &step[admin[theActor].step];
+                step = (StepEntry *) &step[admin.step[theActor]];
                 /* Now execute it, maybe. First check wait count */
-                if (admin[theActor].waitCount > 0) { /* Wait some more ? */
+                if (admin.waitCount[theActor] > 0) { /* Wait some more ? */
                     if (traceActor(theActor))
                         printf(", SCRIPT %s[%ld], STEP %ld, Waiting another %ld turns>\n",
-                               scriptName(theActor, admin[theActor].script),
-                               (long)admin[theActor].script, (long)admin[theActor].step+1,
-                               (long)admin[theActor].waitCount);
-                    admin[theActor].waitCount--;
+                               scriptName(theActor, admin.script[theActor]),
+                               (long)admin.script[theActor], (long)admin.step[theActor]+1,
+                               (long)admin.waitCount[theActor]);
+                    admin.waitCount[theActor]--;
                     break;
                 }
                 /* Then check possible expression to wait for */
                 if (step->exp != 0) {
                     if (traceActor(theActor))
                         printf(", SCRIPT %s[%ld], STEP %ld, Evaluating:>\n",
-                               scriptName(theActor, admin[theActor].script),
-                               (long)admin[theActor].script, (long)admin[theActor].step+1);
+                               scriptName(theActor, admin.script[theActor]),
+                               (long)admin.script[theActor], (long)admin.step[theActor]+1);
                     if (!evaluate(step->exp))
                         break;		/* Break loop, don't execute step*/
                 }
                 /* OK, so finally let him do his thing */
-                admin[theActor].step++;		/* Increment step number before executing... */
+                admin.step[theActor]++;		/* Increment step number before executing... */
                 if (!isEndOfArray(step+1) && (step+1)->after != 0) {
-                    admin[theActor].waitCount = evaluate((step+1)->after);
+                    admin.waitCount[theActor] = evaluate((step+1)->after);
                 }
                 if (traceActor(theActor))
                     printf(", SCRIPT %s[%ld], STEP %ld, Executing:>\n",
-                           scriptName(theActor, admin[theActor].script),
-                           (long)admin[theActor].script,
-                           (long)admin[theActor].step);
+                           scriptName(theActor, admin.script[theActor]),
+                           (long)admin.script[theActor],
+                           (long)admin.step[theActor]);
                 interpret(step->stms);
                 step++;
                 /* ... so that we can see if he failed or is USEing another script now */
-                if (fail || (admin[theActor].step != 0 && isEndOfArray(step)))
+                if (fail || (admin.step[theActor] != 0 && isEndOfArray(step)))
                     /* No more steps in this script, so stop him */
-                    admin[theActor].script = 0;
+                    admin.script[theActor] = 0;
                 fail = false;			/* fail only aborts one actor */
                 break;			/* We have executed a script so leave loop */
             }
@@ -804,13 +832,39 @@ static void moveActor(int theActor)
 #define ERROR_RETURNED (setjmp(returnLabel) != NO_JUMP_RETURN)
 
 /*======================================================================*/
-void run(void)
+/* Open and load the game, ready to be played */
+void loadGame(void)
+{
+    openFiles();
+    load();
+}
+
+
+/*======================================================================*/
+/* Close and release the loaded game, if any, so that another one can
+   be loaded */
+void unloadGame(void)
+{
+    if (codfil != NULL)
+        fclose(codfil);
+    codfil = NULL;
+    if (textFile != NULL)
+        fclose(textFile);
+    textFile = NULL;
+    if (memory != NULL && !unloadImage())
+        deallocate(memory);
+    memory = NULL;
+}
+
+
+/*======================================================================*/
+/* Play the loaded game, this never returns */
+void play(void)
 {
     int i;
     static Stack theStack = NULL; /* Needs to survive longjmp() */
 
-    openFiles();
-    load();			/* Load program */
+    openLogFiles();
 
     if ((debugOption && !regressionTestOption) || verboseOption) {
         if (!isPreBeta7(header->version)) {
@@ -823,6 +877,8 @@ void run(void)
 
     if (RESTARTED) {
         deleteStack(theStack);
+        resetTemporaries();
+        abandonPrinting();
     }
 
     theStack = createStack(STACKSIZE);
@@ -834,6 +890,8 @@ void run(void)
         init(theStack);               /* Initialise and start the adventure */
 
     while (true) {
+        resetTemporaries();     /* Nothing temporary survives a command */
+
         if (debugOption)
             debug(false, 0, 0);
 
@@ -848,10 +906,14 @@ void run(void)
         case NO_JUMP_RETURN:
             break;
         case ERROR_RETURN:
+            resetTemporaries();
+            abandonPrinting();
             forgetGameState();
             forceNewPlayerInput();
             break;
         case UNDO_RETURN:
+            resetTemporaries();
+            abandonPrinting();
             forceNewPlayerInput();
             break;
         default:
@@ -885,3 +947,13 @@ void run(void)
         }
     }
 }
+
+
+/*======================================================================*/
+void run(void)
+{
+    loadGame();
+    if (replayFileName != NULL)
+        startReplay(replayFileName);
+    play();
+}
@@ -23,5 +23,8 @@ extern VerbEntry *vrbs;		/* Verb table pointer */
 
 /* Run the game! */
 extern void run(void);
+extern void loadGame(void);
+extern void unloadGame(void);
+extern void play(void);
 
 #endif
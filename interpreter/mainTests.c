@@ -19,7 +19,7 @@ Ensure(Main, canCopyAttributes) {
 
     header = allocate(sizeof(ACodeHeader));
     header->instanceMax = 2;
-    admin = allocate(3*sizeof(AdminEntry));
+    admin.attributes = allocate(3*sizeof(AttributeEntry *));
     instances = allocate(3*sizeof(InstanceEntry));
 
     /* Create two attribute lists which consists of two attributes each,
@@ -45,21 +45,21 @@ Ensure(Main, canCopyAttributes) {
 
     initializeAttributes(5*sizeof(AttributeEntry)/sizeof(Aword));
 
-    assert_true(admin[1].attributes[0].code == 13);
-    assert_true(admin[1].attributes[0].value == 15);
-    assert_true(admin[1].attributes[0].id == 17);
-    assert_true(admin[1].attributes[1].code == 19);
-    assert_true(admin[1].attributes[1].value == 21);
-    assert_true(admin[1].attributes[1].id == 23);
-    assert_true(*(Aword*)&admin[1].attributes[2] == EOF);
-
-    assert_true(admin[2].attributes[0].code == 130);
-    assert_true(admin[2].attributes[0].value == 150);
-    assert_true(admin[2].attributes[0].id == 170);
-    assert_true(admin[2].attributes[1].code == 190);
-    assert_true(admin[2].attributes[1].value == 210);
-    assert_true(admin[2].attributes[1].id == 230);
-    assert_true(*(Aword*)&admin[2].attributes[2] == EOF);
+    assert_true(admin.attributes[1][0].code == 13);
+    assert_true(admin.attributes[1][0].value == 15);
+    assert_true(admin.attributes[1][0].id == 17);
+    assert_true(admin.attributes[1][1].code == 19);
+    assert_true(admin.attributes[1][1].value == 21);
+    assert_true(admin.attributes[1][1].id == 23);
+    assert_true(*(Aword*)&admin.attributes[1][2] == EOF);
+
+    assert_true(admin.attributes[2][0].code == 130);
+    assert_true(admin.attributes[2][0].value == 150);
+    assert_true(admin.attributes[2][0].id == 170);
+    assert_true(admin.attributes[2][1].code == 190);
+    assert_true(admin.attributes[2][1].value == 210);
+    assert_true(admin.attributes[2][1].id == 230);
+    assert_true(*(Aword*)&admin.attributes[2][2] == EOF);
 }
 
 Ensure(Main, canHandleMemoryStartForPre3_0alpha5IsShorter) {
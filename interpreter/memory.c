@@ -18,82 +18,330 @@ ACodeHeader *header = &dummyHeader;
 int memTop = 0;                 /* Top of load memory */
 
 /* Private data */
-typedef struct {
-    Aptr aptr;
-    void *voidp;
-} PointerMapEntry;
-
-/* (64-bit) pointers mapped to 32-bit Awords through mapping table:
-   Aptrs are numbered incrementally for each address that needs to be mapped.
-   A slot in the table is empty if its voidp field == NULL.
-   That slot can then be reused, so index in the table bears no meaning.
+
+/* (64-bit) pointers mapped to 32-bit Awords through a handle table:
+
+   Aptr -> pointer: the Aptr is an index into a dense array of slots,
+   tagged with a generation number so that an Aptr which has been
+   forgotten is not mistaken for a later one reusing the same
+   slot. Free slots are linked in a free list so they can be reused.
+
+   pointer -> Aptr: an open addressing (linear probing) hash table
+   of slot indices, keyed on the pointer.
+
+   All operations are O(1) amortized.
 */
 
-static PointerMapEntry *pointerMap = NULL;
-static int pointerMapSize = 0;
-static int nextAptr = 1;
+#define SLOT_BITS 24
+#define SLOT_MASK ((1<<SLOT_BITS)-1)
+#define MAX_GENERATION 127      /* Keep the Aptr positive as an Aint */
+#define NO_SLOT (-1)
+
+typedef struct {
+    void *voidp;                /* NULL if the slot is free */
+    int generation;
+    int nextFree;
+} PointerSlot;
+
+static PointerSlot *pointerSlots = NULL;
+static int pointerSlotsSize = 0;
+static int pointerSlotsUsed = 0;
+static int freePointerSlot = NO_SLOT;
+
+static int *pointerHash = NULL;  /* Slot indices, NO_SLOT if empty */
+static int pointerHashSize = 0;   /* Always a power of two */
+static int pointerHashCount = 0;
+
+
+/* Temporary memory, which is only needed during one player command,
+   is allocated from an arena, a chain of blocks which is reset at the
+   start of every command and when an error aborts it. Deallocating a
+   temporary is allowed, and releases its space as soon as everything
+   allocated after it is also released, so temporaries deallocated in
+   good order do not make the arena grow. */
+
+#define ARENA_BLOCK_SIZE (64*1024)
+#define ARENA_ALIGNMENT 16
+#define NO_TEMPORARY ((size_t)-1)
+
+typedef struct TemporaryHeader {
+    size_t previous;            /* Offset of the temporary before, or NO_TEMPORARY */
+    bool released;
+} TemporaryHeader;
+
+#define TEMPORARY_HEADER_SIZE aligned(sizeof(TemporaryHeader))
+
+typedef struct ArenaBlock {
+    struct ArenaBlock *next;
+    char *data;
+    size_t size;
+    size_t used;
+    size_t last;                /* Offset of the last temporary, or NO_TEMPORARY */
+} ArenaBlock;
+
+static ArenaBlock *arena = NULL;
+static ArenaBlock *currentBlock = NULL;
+
+
+/*----------------------------------------------------------------------*/
+static Aptr aptrForSlot(int slot) {
+    return ((Aptr)pointerSlots[slot].generation<<SLOT_BITS) | (Aptr)slot;
+}
+
+
+/*----------------------------------------------------------------------*/
+static int hashOf(void *ptr) {
+    uintptr_t key = (uintptr_t)ptr;
+    key ^= key >> 17;
+    key *= 0x9E3779B1u;
+    return (int)((key ^ (key >> 15)) & (pointerHashSize-1));
+}
+
+
+/*----------------------------------------------------------------------*/
+static int findHashIndex(void *ptr) {
+    int index;
+
+    if (pointerHashSize == 0)
+        return NO_SLOT;
+
+    for (index = hashOf(ptr); pointerHash[index] != NO_SLOT; index = (index+1) & (pointerHashSize-1))
+        if (pointerSlots[pointerHash[index]].voidp == ptr)
+            return index;
+    return NO_SLOT;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void insertInHash(int slot) {
+    int index;
+
+    for (index = hashOf(pointerSlots[slot].voidp); pointerHash[index] != NO_SLOT;
+         index = (index+1) & (pointerHashSize-1))
+        ;
+    pointerHash[index] = slot;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void growHash(void) {
+    int *oldHash = pointerHash;
+    int oldSize = pointerHashSize;
+
+    pointerHashSize = oldSize == 0? 64 : 2*oldSize;
+    pointerHash = allocate(pointerHashSize*sizeof(int));
+    for (int index = 0; index < pointerHashSize; index++)
+        pointerHash[index] = NO_SLOT;
+
+    for (int index = 0; index < oldSize; index++)
+        if (oldHash[index] != NO_SLOT)
+            insertInHash(oldHash[index]);
+    free(oldHash);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void removeFromHash(int index) {
+    int mask = pointerHashSize-1;
+    int next;
+
+    /* Backward shift deletion to keep probe sequences unbroken */
+    pointerHash[index] = NO_SLOT;
+    for (next = (index+1) & mask; pointerHash[next] != NO_SLOT; next = (next+1) & mask) {
+        int home = hashOf(pointerSlots[pointerHash[next]].voidp);
+        /* Can the entry at 'next' be moved to the hole at 'index'? */
+        if (((next - home) & mask) >= ((next - index) & mask)) {
+            pointerHash[index] = pointerHash[next];
+            pointerHash[next] = NO_SLOT;
+            index = next;
+        }
+    }
+    pointerHashCount--;
+}
+
+
+/*----------------------------------------------------------------------*/
+static int allocatePointerSlot(void) {
+    int slot;
+
+    if (freePointerSlot != NO_SLOT) {
+        slot = freePointerSlot;
+        freePointerSlot = pointerSlots[slot].nextFree;
+        return slot;
+    }
+
+    if (pointerSlotsUsed == pointerSlotsSize) {
+        if (pointerSlotsSize > SLOT_MASK/2)
+            syserr("Too many pointers mapped to Aptr");
+        pointerSlotsSize = pointerSlotsSize == 0? 64 : 2*pointerSlotsSize;
+        pointerSlots = realloc(pointerSlots, pointerSlotsSize*sizeof(PointerSlot));
+        if (pointerSlots == NULL)
+            syserr("Out of memory.");
+    }
+    slot = pointerSlotsUsed++;
+    pointerSlots[slot].generation = 1;
+    return slot;
+}
 
 
 /*======================================================================*/
 void resetPointerMap(void) {
-    if (pointerMap != NULL) free(pointerMap);
-    pointerMap = NULL;
-    pointerMapSize = 0;
+    free(pointerSlots);
+    pointerSlots = NULL;
+    pointerSlotsSize = 0;
+    pointerSlotsUsed = 0;
+    freePointerSlot = NO_SLOT;
+
+    free(pointerHash);
+    pointerHash = NULL;
+    pointerHashSize = 0;
+    pointerHashCount = 0;
 }
 
 /*======================================================================*/
 void *fromAptr(Aptr aptr) {
-    int index;
+    int slot = aptr & SLOT_MASK;
 
-    for (index=0; index < pointerMapSize && pointerMap[index].aptr != aptr; index++)
-        ;
-
-    if (index == pointerMapSize)
+    if (slot >= pointerSlotsUsed || pointerSlots[slot].voidp == NULL
+        || aptrForSlot(slot) != aptr)
         syserr("No pointerMap entry for Aptr");
 
-    return pointerMap[index].voidp;
+    return pointerSlots[slot].voidp;
 }
 
 
 /*======================================================================*/
 Aptr toAptr(void *ptr) {
     int index;
+    int slot;
+
+    /* Already mapped? */
+    index = findHashIndex(ptr);
+    if (index != NO_SLOT)
+        return aptrForSlot(pointerHash[index]);
+
+    /* Keep the load factor below one half */
+    if (2*(pointerHashCount+1) > pointerHashSize)
+        growHash();
+
+    slot = allocatePointerSlot();
+    pointerSlots[slot].voidp = ptr;
+    insertInHash(slot);
+    pointerHashCount++;
+
+    return aptrForSlot(slot);
+}
+
+/*-------------------------------------------------------------------------------*/
+static void forgetAptr(void *ptr) {
+    int index = findHashIndex(ptr);
+    int slot;
+
+    if (index == NO_SLOT)
+        return;
+
+    slot = pointerHash[index];
+    removeFromHash(index);
+
+    pointerSlots[slot].voidp = NULL;
+    pointerSlots[slot].generation = pointerSlots[slot].generation % MAX_GENERATION + 1;
+    pointerSlots[slot].nextFree = freePointerSlot;
+    freePointerSlot = slot;
+}
+
+/*----------------------------------------------------------------------*/
+static size_t aligned(size_t size) {
+    return (size + ARENA_ALIGNMENT-1) & ~(size_t)(ARENA_ALIGNMENT-1);
+}
+
+
+/*----------------------------------------------------------------------*/
+static ArenaBlock *newArenaBlock(size_t minimumSize) {
+    ArenaBlock *block = malloc(sizeof(ArenaBlock));
+
+    if (block == NULL)
+        syserr("Out of memory.");
+    block->size = minimumSize > ARENA_BLOCK_SIZE? minimumSize : ARENA_BLOCK_SIZE;
+    block->data = malloc(block->size);
+    if (block->data == NULL)
+        syserr("Out of memory.");
+    block->next = NULL;
+    block->used = 0;
+    block->last = NO_TEMPORARY;
+    return block;
+}
+
+
+/*----------------------------------------------------------------------*/
+static ArenaBlock *blockOf(void *pointer) {
+    ArenaBlock *block;
+
+    for (block = arena; block != NULL; block = block->next)
+        if ((char *)pointer >= block->data && (char *)pointer < block->data + block->size)
+            return block;
+    return NULL;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void releaseTemporary(ArenaBlock *block, void *pointer) {
+    TemporaryHeader *temporary = (TemporaryHeader *)((char *)pointer - TEMPORARY_HEADER_SIZE);
 
-    if (pointerMap == NULL) {
-        pointerMap = (PointerMapEntry *)allocate(sizeof(PointerMapEntry));
-        pointerMapSize = 1;
+    temporary->released = true;
+    while (block->last != NO_TEMPORARY) {
+        temporary = (TemporaryHeader *)(block->data + block->last);
+        if (!temporary->released)
+            break;
+        block->used = block->last;
+        block->last = temporary->previous;
     }
+}
 
-    /* Search for ptr */
-    for (index=0; index < pointerMapSize; index++)
-        if (pointerMap[index].voidp == ptr)
-            return pointerMap[index].aptr;
 
-    /* So find a free slot */
-    for (index=0; index < pointerMapSize && pointerMap[index].voidp != NULL; index++)
-        ;
+/*======================================================================*/
+void *allocateTemporary(unsigned long lengthInBytes) {
+    size_t needed = TEMPORARY_HEADER_SIZE + aligned(lengthInBytes);
+    TemporaryHeader *temporary;
+    void *p;
 
-    /* Need to extend pointerMap */
-    if (index == pointerMapSize) {
-        pointerMap = realloc(pointerMap, (index+1)*sizeof(PointerMapEntry));
-        pointerMapSize++;
+    if (arena == NULL)
+        arena = currentBlock = newArenaBlock(needed);
+    while (currentBlock->used + needed > currentBlock->size) {
+        if (currentBlock->next == NULL)
+            currentBlock->next = newArenaBlock(needed);
+        currentBlock = currentBlock->next;
     }
 
-    pointerMap[index].voidp = ptr;
-    pointerMap[index].aptr = nextAptr++;
-    return pointerMap[index].aptr;
+    temporary = (TemporaryHeader *)(currentBlock->data + currentBlock->used);
+    temporary->previous = currentBlock->last;
+    temporary->released = false;
+    currentBlock->last = currentBlock->used;
+    currentBlock->used += needed;
+
+    p = (char *)temporary + TEMPORARY_HEADER_SIZE;
+    memset(p, 0, lengthInBytes);
+    return p;
 }
 
-/*-------------------------------------------------------------------------------*/
-static void forgetAptr(void *ptr) {
-    for (int index=0; index < pointerMapSize; index++)
-        if (pointerMap[index].voidp == ptr) {
-            pointerMap[index].aptr = 0;
-            pointerMap[index].voidp = NULL;
-            return;
-        }
+
+/*======================================================================*/
+bool isTemporary(void *pointer) {
+    return pointer != NULL && blockOf(pointer) != NULL;
+}
+
+
+/*======================================================================*/
+void resetTemporaries(void) {
+    ArenaBlock *block;
+
+    for (block = arena; block != NULL; block = block->next) {
+        block->used = 0;
+        block->last = NO_TEMPORARY;
+    }
+    currentBlock = arena;
 }
 
+
 /* Allocation/Deallocation: */
 /*======================================================================*/
 void *allocate(unsigned long lengthInBytes)
@@ -110,8 +358,13 @@ void *allocate(unsigned long lengthInBytes)
 /*======================================================================*/
 void deallocate(void *memory)
 {
+    ArenaBlock *block;
+
     forgetAptr(memory);
-    free(memory);
+    if (memory != NULL && (block = blockOf(memory)) != NULL)
+        releaseTemporary(block, memory);
+    else
+        free(memory);
 }
 
 
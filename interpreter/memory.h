@@ -32,6 +32,10 @@ extern void *allocate(unsigned long lengthInBytes);
 extern void *duplicate(void *original, unsigned long len);
 extern void deallocate(void *memory);
 
+extern void *allocateTemporary(unsigned long lengthInBytes);
+extern bool isTemporary(void *pointer);
+extern void resetTemporaries(void);
+
 extern void resetPointerMap(void);
 extern void *fromAptr(Aptr aptr);
 extern Aptr toAptr(void *ptr);
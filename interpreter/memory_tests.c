@@ -56,3 +56,114 @@ Ensure(Memory, will_forget_aptr_for_deallocated_memory) {
     expect(syserr);
     fromAptr(aptr);
 }
+
+Ensure(Memory, can_map_and_forget_100000_live_pointers) {
+#define LIVE_POINTERS 100000
+    static void *pointers[LIVE_POINTERS];
+    static Aptr aptrs[LIVE_POINTERS];
+    int i;
+
+    resetPointerMap();
+    for (i = 0; i < LIVE_POINTERS; i++) {
+        pointers[i] = allocate(1);
+        aptrs[i] = toAptr(pointers[i]);
+    }
+
+    for (i = 0; i < LIVE_POINTERS; i++) {
+        if (fromAptr(aptrs[i]) != pointers[i])
+            fail_test("Wrong pointer for aptr");
+        if (toAptr(pointers[i]) != aptrs[i])
+            fail_test("Different aptr for same pointer");
+    }
+
+    /* Forget every other one and map new pointers in their place */
+    for (i = 0; i < LIVE_POINTERS; i += 2) {
+        deallocate(pointers[i]);
+        pointers[i] = allocate(1);
+        aptrs[i] = toAptr(pointers[i]);
+    }
+
+    for (i = 0; i < LIVE_POINTERS; i++)
+        if (fromAptr(aptrs[i]) != pointers[i])
+            fail_test("Wrong pointer for aptr after reuse");
+
+    for (i = 0; i < LIVE_POINTERS; i++)
+        deallocate(pointers[i]);
+    resetPointerMap();
+}
+
+Ensure(Memory, will_not_confuse_forgotten_aptr_with_one_reusing_its_slot) {
+    void *first = allocate(5);
+    Aptr forgotten = toAptr(first);
+    void *second;
+
+    deallocate(first);
+    second = allocate(5);
+
+    assert_that(toAptr(second), is_not_equal_to(forgotten));
+    expect(syserr);
+    fromAptr(forgotten);
+}
+
+Ensure(Memory, can_allocate_zeroed_temporary_memory) {
+    char *temporary;
+
+    resetTemporaries();
+    temporary = allocateTemporary(10);
+
+    assert_that(isTemporary(temporary));
+    assert_that(temporary[0], is_equal_to(0));
+    assert_that(temporary[9], is_equal_to(0));
+}
+
+Ensure(Memory, does_not_consider_allocated_memory_temporary) {
+    void *allocated = allocate(5);
+
+    assert_that(!isTemporary(allocated));
+    deallocate(allocated);
+}
+
+Ensure(Memory, reuses_temporary_memory_after_reset) {
+    void *first;
+
+    resetTemporaries();
+    first = allocateTemporary(100);
+    resetTemporaries();
+
+    assert_that(allocateTemporary(100), is_equal_to(first));
+}
+
+Ensure(Memory, keeps_a_deallocated_temporary_while_later_ones_are_in_use) {
+    void *first;
+
+    resetTemporaries();
+    first = allocateTemporary(100);
+    allocateTemporary(100);
+
+    deallocate(first);
+    assert_that(allocateTemporary(100), is_not_equal_to(first));
+}
+
+Ensure(Memory, releases_temporaries_deallocated_in_reverse_order) {
+    void *first, *second;
+
+    resetTemporaries();
+    first = allocateTemporary(100);
+    second = allocateTemporary(100);
+
+    deallocate(second);
+    deallocate(first);
+
+    assert_that(allocateTemporary(100), is_equal_to(first));
+}
+
+Ensure(Memory, can_allocate_temporaries_larger_than_a_block) {
+    char *large;
+
+    resetTemporaries();
+    large = allocateTemporary(1000000);
+
+    large[999999] = 'x';
+    assert_that(isTemporary(&large[999999]));
+    resetTemporaries();
+}
@@ -65,7 +65,7 @@ void abortPlayerCommand(void)
 
 /*======================================================================*/
 void printMessageWithInstanceParameter(MsgKind message, int instanceId) {
-    ParameterArray parameters = newParameterArray();
+    ParameterArray parameters = newTemporaryParameterArray();
     addParameterForInstance(parameters, instanceId);
     printMessageWithParameters(message, parameters);
     freeParameterArray(parameters);
@@ -74,7 +74,7 @@ void printMessageWithInstanceParameter(MsgKind message, int instanceId) {
 
 /*======================================================================*/
 void printMessageUsing2InstanceParameters(MsgKind message, int instance1, int instance2) {
-    ParameterArray parameters = newParameterArray();
+    ParameterArray parameters = newTemporaryParameterArray();
     addParameterForInstance(parameters, instance1);
     addParameterForInstance(parameters, instance2);
     printMessageWithParameters(message, parameters);
@@ -85,7 +85,7 @@ void printMessageUsing2InstanceParameters(MsgKind message, int instance1, int in
 /*======================================================================*/
 void printMessageWithParameters(MsgKind msg, Parameter *messageParameters)
 {
-    Parameter *savedParameters = newParameterArray();
+    Parameter *savedParameters = newTemporaryParameterArray();
 
     copyParameterArray(savedParameters, globalParameters);
     copyParameterArray(globalParameters, messageParameters);
@@ -13,4 +13,12 @@ bool commandLogOption = false;
 bool statusLineOption = true;
 bool regressionTestOption = false;
 bool nopagingOption = false;
+bool profileOption = false;
+bool imageOption = false;
+bool walkClassesOption = false; /* Debugging: isA() walks the class parents */
+bool evaluateAllRulesOption = false; /* Debugging: evaluate every rule every time */
+bool checkRulesOption = false;
 int encodingOption = 0;         /* 0 = ISO, 1 = UTF-8 */
+int undoLevelsOption = -1;      /* Undo levels to retain, -1 = unlimited */
+int textCacheOption = 256;      /* Kilobytes of decoded text to keep */
+int batchWorkersOption = 0;     /* Sessions to play at once, 0 = one per processor */
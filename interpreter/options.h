@@ -16,11 +16,20 @@ extern bool commandLogOption;
 extern bool statusLineOption;
 extern bool regressionTestOption;
 extern bool nopagingOption;
+extern bool profileOption;
+extern bool imageOption;
+extern bool walkClassesOption;
+extern bool evaluateAllRulesOption;
+extern bool checkRulesOption;
 
 #define ENCODING_ISO 0
 #define ENCODING_UTF 1
 extern int encodingOption;         /* 0 = ISO, 1 = UTF-8 */
 
+extern int undoLevelsOption;       /* Undo levels to retain, -1 = unlimited */
+extern int textCacheOption;        /* Kilobytes of decoded text to keep */
+extern int batchWorkersOption;     /* Sessions to play at once, 0 = one per processor */
+
 
 /* FUNCTIONS: */
 extern void usage(char *programName);
@@ -13,6 +13,7 @@
 #include "readline.h"
 #include "instance.h"
 #include "converter.h"
+#include "replay.h"
 
 
 #ifdef HAVE_GLK
@@ -25,6 +26,9 @@ bool capitalize = false;
 bool needSpace = false;
 bool skipSpace = false;
 
+/* Nothing is printed while replaying a command log, see suppressOutput() */
+bool outputSuppressed = false;
+
 /* Screen formatting info */
 int col, lin;
 int pageLength, pageWidth;
@@ -39,6 +43,16 @@ FILE *transcriptFile;
 #endif
 
 
+/* PRIVATE DATA */
+#ifndef HAVE_GLK
+/* Output in external encoding, written to the transcript at the
+   next flushTranscript() */
+#define TRANSCRIPT_BUFFER_SIZE 8192
+static char transcriptBuffer[TRANSCRIPT_BUFFER_SIZE];
+static int transcriptLength = 0;
+#endif
+
+
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 
 
@@ -54,6 +68,50 @@ static int updateColumn(int currentColumn, char *string) {
 #endif
 
 
+/*======================================================================*/
+/* Write the output collected for the transcript, which must be done
+   before anything else is written to it and when it is stopped */
+void flushTranscript(void) {
+#ifndef HAVE_GLK
+    if (transcriptLength > 0 && transcriptOption && transcriptFile != NULL) {
+        fwrite(transcriptBuffer, 1, transcriptLength, transcriptFile);
+        fflush(transcriptFile);
+    }
+    transcriptLength = 0;
+#endif
+}
+
+
+/*======================================================================*/
+/* Forget the output collected for the transcript without writing it */
+void discardTranscript(void) {
+#ifndef HAVE_GLK
+    transcriptLength = 0;
+#endif
+}
+
+
+/*======================================================================*/
+/* Stop printing anything. Everything else output does, such as running
+   the code for parameters in texts and noting that there was output,
+   still happens, so that the game ends up in the same state. */
+void suppressOutput(void) {
+    outputSuppressed = true;
+}
+
+
+/*======================================================================*/
+/* Start printing again, at the beginning of a new line and page */
+void resumeOutput(void) {
+    outputSuppressed = false;
+    col = 1;
+    lin = 0;
+    needSpace = false;
+    skipSpace = false;
+    capitalize = true;
+}
+
+
 /*======================================================================*/
 void setSubHeaderStyle(void) {
 #ifdef HAVE_GLK
@@ -72,6 +130,12 @@ void setNormalStyle(void) {
 /*======================================================================*/
 void newline(void)
 {
+    if (outputSuppressed) {
+        col = 1;
+        needSpace = false;
+        return;
+    }
+
 #ifndef HAVE_GLK
     char buf[256];
 
@@ -103,7 +167,7 @@ void para(void)
     /* Make a new paragraph, i.e one empty line (one or two newlines). */
 
 #ifdef HAVE_GLK
-    if (glk_gestalt(gestalt_Graphics, 0) == 1)
+    if (!outputSuppressed && glk_gestalt(gestalt_Graphics, 0) == 1)
         glk_window_flow_break(glkMainWin);
 #endif
     if (col != 1)
@@ -133,8 +197,8 @@ static void capitalizeFirst(char *str) {
     int i = 0;
 
     /* Skip over space... */
-    while (i < strlen(str) && isSpace(str[i])) i++;
-    if (i < strlen(str)) {
+    while (str[i] != '\0' && isSpace(str[i])) i++;
+    if (str[i] != '\0') {
         str[i] = toUpper(str[i]);
         capitalize = false;
     }
@@ -142,18 +206,15 @@ static void capitalizeFirst(char *str) {
 
 
 
+#ifdef HAVE_GLK
 /*======================================================================*/
 void printAndLog(char string[])
 {
-    /* TODO: clean up the GLK code to use same converted string */
-#ifdef HAVE_GLK
+    if (outputSuppressed)
+        return;
+
     printf("%s", string);
-#else
-    char *outputString = ensureExternalEncoding(string);
-    printf("%s", outputString);
-#endif
 
-#ifdef HAVE_GLK
     if (!onStatusLine && transcriptOption) {
         static int column = 0;
         char *stringCopy;
@@ -183,32 +244,67 @@ void printAndLog(char string[])
         column = updateColumn(column, stringPart);
         free(stringCopy);
     }
+}
+
 #else
-    if (!onStatusLine && transcriptOption) {
-        fprintf(transcriptFile, "%s", outputString);
-        fflush(transcriptFile);
+
+/*----------------------------------------------------------------------*/
+static void printAndLogPart(char string[], int length)
+{
+    /* Converted straight into the transcript buffer, and only kept
+       there if it should be logged. Stdout is written immediately as
+       traces, the debugger and the status line also print on it. */
+    while (length > 0) {
+        int part = (TRANSCRIPT_BUFFER_SIZE-transcriptLength)/MAX_EXTERNAL_CHARACTER_LENGTH;
+        char *converted = &transcriptBuffer[transcriptLength];
+        int bytes;
+
+        if (part == 0) {
+            flushTranscript();
+            continue;
+        }
+        if (part > length)
+            part = length;
+        bytes = toExternalEncoding(converted, string, part);
+        fwrite(converted, 1, bytes, stdout);
+        if (!onStatusLine && transcriptOption)
+            transcriptLength += bytes;
+        string += part;
+        length -= part;
     }
-    free(outputString);
-#endif
 }
 
 
+/*======================================================================*/
+void printAndLog(char string[])
+{
+    if (!outputSuppressed)
+        printAndLogPart(string, strlen(string));
+}
+#endif
+
+
 /*----------------------------------------------------------------------*/
 static void justify(char str[])
 {
+    if (outputSuppressed)
+        return;
+
     if (capitalize)
         capitalizeFirst(str);
 
 #ifdef HAVE_GLK
     printAndLog(str);
+    col = col + strlen(str);  /* Update column */
 #else
     int i;
-    char ch;
+    char *end = &str[strlen(str)];
 
     if (col >= pageWidth && !skipSpace)
         newline();
 
-    while (strlen(str) > pageWidth - col) {
+    /* Compared unsigned, so a column beyond the page width never wraps */
+    while ((size_t)(end - str) > pageWidth - col) {
         i = pageWidth - col - 1;
         while (!isSpace(str[i]) && i > 0) /* First find wrap point */
             i--;
@@ -217,20 +313,17 @@ static void justify(char str[])
             while (!isSpace(str[i]) && str[i] != '\0')
                 i++;
         if (i > 0) {        /* If it fits ... */
-            ch = str[i];      /* Save space or NULL */
-            str[i] = '\0';        /* Terminate string */
-            printAndLog(str);     /* and print it */
+            printAndLogPart(str, i); /* print up to the space or end */
             skipSpace = false;        /* If skipping, now we're done */
-            str[i] = ch;      /* Restore character */
             /* Skip white after printed portion */
             for (str = &str[i]; isSpace(str[0]) && str[0] != '\0'; str++);
         }
         newline();          /* Then start a new line */
         while(isSpace(str[0])) str++; /* Skip any leading space on next part */
     }
-    printAndLog(str);     /* Print tail */
+    printAndLogPart(str, end - str); /* Print tail */
+    col = col + (end - str);  /* Update column */
 #endif
-    col = col + strlen(str);  /* Update column */
 }
 
 
@@ -437,6 +530,17 @@ static char lastCharOf(char *str) {
 }
 
 
+/*----------------------------------------------------------------------*/
+static void runSymbols(char str[])
+{
+    char *symptr;
+
+    /* Symbols may say instances, which runs their code */
+    while ((symptr = strchr(str, '$')) != (char *) NULL)
+        str = printSymbol(symptr);
+}
+
+
 /*======================================================================*/
 void output(char original[])
 {
@@ -447,6 +551,12 @@ void output(char original[])
     if (strlen(original) == 0)
         return;
 
+    if (outputSuppressed) {
+        runSymbols(original);
+        anyOutput = true;
+        return;
+    }
+
     copy = strdup(original);
     str = copy;
 
@@ -497,6 +607,9 @@ bool confirm(MsgKind msgno)
        it could be affirmative, but for now any input is NOT! */
     printMessage(msgno);
 
+    /* The command log has no answers, so take it as a no */
+    if (replaying()) return false;
+
 #ifdef USE_READLINE
     if (!readline(buf)) return true;
 #else
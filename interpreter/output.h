@@ -18,6 +18,7 @@ extern int pageLength, pageWidth;
 extern bool anyOutput;
 extern bool needSpace;
 extern bool capitalize;
+extern bool outputSuppressed;
 
 /* Log files */
 #ifdef HAVE_GLK
@@ -31,12 +32,16 @@ extern FILE *commandLogFile;
 
 
 /* FUNCTIONS */
+extern void suppressOutput(void);
+extern void resumeOutput(void);
 extern void setSubHeaderStyle(void);
 extern void setNormalStyle(void);
 extern void newline(void);
 extern void para(void);
 extern void clear(void);
 extern void printAndLog(char string[]);
+extern void flushTranscript(void);
+extern void discardTranscript(void);
 extern void output(char string[]);
 
 #endif /* OUTPUT_H_ */
@@ -36,3 +36,19 @@ Ensure(Output, testSpaceEquivalent){
   assert_true(!isSpaceEquivalent(""));
   assert_true(isSpaceEquivalent(" "));
 }
+
+Ensure(Output, suppressedOutputIsNotedButNotFormatted) {
+  col = 7;
+  lin = 3;
+  anyOutput = false;
+
+  suppressOutput();
+  output("Nothing of this is printed,$nnor is a new line counted.");
+  assert_true(anyOutput);
+  assert_true(lin == 3);
+  assert_true(col == 1);
+
+  resumeOutput();
+  assert_false(outputSuppressed);
+  assert_true(lin == 0);
+}
@@ -10,6 +10,7 @@
 /* IMPORTS */
 #include "lists.h"
 #include "memory.h"
+#include "bitset.h"
 #include "literal.h"
 #include "syserr.h"
 
@@ -19,8 +20,9 @@ Parameter *globalParameters = NULL;
 
 
 /*======================================================================*/
+/* A single parameter is only needed during the command */
 Parameter *newParameter(int id) {
-    Parameter *parameter = NEW(Parameter);
+    Parameter *parameter = allocateTemporary(sizeof(Parameter));
     parameter->instance = id;
     parameter->candidates = NULL;
 
@@ -36,6 +38,15 @@ Parameter *newParameterArray(void) {
 }
 
 
+/*======================================================================*/
+/* A parameter array which is only needed during the command */
+Parameter *newTemporaryParameterArray(void) {
+    Parameter *newArray = allocateTemporary((MAXINSTANCE+1)*sizeof(Parameter));
+    setEndOfArray(newArray);
+    return newArray;
+}
+
+
 /*======================================================================*/
 void freeParameterArray(ParameterArray arrayPointer) {
     Parameter *p;
@@ -58,6 +69,17 @@ Parameter *ensureParameterArrayAllocated(ParameterArray currentArray) {
 }
 
 
+/*======================================================================*/
+Parameter *ensureTemporaryParameterArrayAllocated(ParameterArray currentArray) {
+    if (currentArray == NULL)
+        return newTemporaryParameterArray();
+    else {
+        clearParameterArray(currentArray);
+        return currentArray;
+    }
+}
+
+
 /*======================================================================*/
 bool parameterArrayIsEmpty(ParameterArray array) {
     return array == NULL || lengthOfParameterArray(array) == 0;
@@ -177,8 +199,9 @@ void copyParameter(Parameter *to, Parameter *from) {
 
     *to = *from;
     if (from->candidates != NULL) {
+        /* Candidates live as long as the parameter they belong to */
         if (toCandidates == NULL)
-            to->candidates = newParameterArray();
+            to->candidates = isTemporary(to)? newTemporaryParameterArray() : newParameterArray();
         else
             to->candidates = toCandidates;
         copyParameterArray(to->candidates, from->candidates);
@@ -221,17 +244,36 @@ void copyParameterArray(ParameterArray to, ParameterArray from)
 }
 
 
+/*----------------------------------------------------------------------*/
+static Bitset *instancesIn(Parameter parameters[]) {
+    Bitset *instances;
+    int size = 1;
+    int i;
+
+    for (i = 0; !isEndOfArray(&parameters[i]); i++)
+        if ((int)parameters[i].instance >= size)
+            size = parameters[i].instance+1;
+    instances = newBitset(size);
+    for (i = 0; !isEndOfArray(&parameters[i]); i++)
+        addToBitset(instances, parameters[i].instance);
+    return instances;
+}
+
+
 /*======================================================================*/
 void subtractParameterArrays(Parameter theArray[], Parameter remove[])
 {
+    Bitset *removed;
     int i;
 
     if (remove == NULL) return;
 
+    removed = instancesIn(remove);
     for (i = 0; !isEndOfArray(&theArray[i]); i++)
-        if (inParameterArray(remove, theArray[i].instance))
+        if (inBitset(removed, theArray[i].instance))
             theArray[i].instance = 0;		/* Mark empty */
     compressParameterArray(theArray);
+    freeBitset(removed);
 }
 
 
@@ -248,13 +290,14 @@ void clearParameterArray(Parameter theArray[]) {
 /*======================================================================*/
 void intersectParameterArrays(Parameter one[], Parameter other[])
 {
+    Bitset *others = instancesIn(other);
     int i, last = 0;
 
-
     for (i = 0; !isEndOfArray(&one[i]); i++)
-        if (inParameterArray(other, one[i].instance))
+        if (inBitset(others, one[i].instance))
             one[last++] = one[i];
     setEndOfArray(&one[last]);
+    freeBitset(others);
 }
 
 
@@ -41,6 +41,8 @@ extern void copyParameter(Parameter *theCopy, Parameter *theOriginal);
 /* ParameterArray: */
 extern ParameterArray newParameterArray(void);
 extern ParameterArray ensureParameterArrayAllocated(ParameterArray currentArray);
+extern ParameterArray newTemporaryParameterArray(void);
+extern ParameterArray ensureTemporaryParameterArrayAllocated(ParameterArray currentArray);
 extern void freeParameterArray(Parameter *array);
 
 extern bool parameterArrayIsEmpty(ParameterArray parameters);
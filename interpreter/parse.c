@@ -13,6 +13,7 @@
 #include <ctype.h>
 
 #include "AltInfo.h"
+#include "bitset.h"
 #include "inter.h"
 #include "current.h"
 #include "act.h"
@@ -120,7 +121,7 @@ static void handleDirectionalCommand() {
 /*----------------------------------------------------------------------*/
 static void errorWhichOne(Parameter alternative[]) {
     int p; /* Index into the list of alternatives */
-    ParameterArray parameters = newParameterArray();
+    ParameterArray parameters = newTemporaryParameterArray();
 
     parameters[0] = alternative[0];
     setEndOfArray(&parameters[1]);
@@ -140,7 +141,7 @@ static void errorWhichOne(Parameter alternative[]) {
 /*----------------------------------------------------------------------*/
 static void errorWhichPronoun(int pronounWordIndex, Parameter alternatives[]) {
     int p; /* Index into the list of alternatives */
-    Parameter *messageParameters = newParameterArray();
+    Parameter *messageParameters = newTemporaryParameterArray();
 
     addParameterForWord(messageParameters, pronounWordIndex);
     printMessageWithParameters(M_WHICH_PRONOUN_START, messageParameters);
@@ -164,7 +165,7 @@ static void errorWhichPronoun(int pronounWordIndex, Parameter alternatives[]) {
 
 /*----------------------------------------------------------------------*/
 static void errorWhat(int playerWordIndex) {
-    Parameter *messageParameters = newParameterArray();
+    Parameter *messageParameters = newTemporaryParameterArray();
 
     addParameterForWord(messageParameters, playerWordIndex);
     printMessageWithParameters(M_WHAT_WORD, messageParameters);
@@ -174,7 +175,7 @@ static void errorWhat(int playerWordIndex) {
 
 /*----------------------------------------------------------------------*/
 static void errorAfterExcept(int butWordIndex) {
-    Parameter *messageParameters = newParameterArray();
+    Parameter *messageParameters = newTemporaryParameterArray();
     addParameterForWord(messageParameters, butWordIndex);
     printMessageWithParameters(M_AFTER_BUT, messageParameters);
     freeParameterArray(messageParameters);
@@ -201,7 +202,7 @@ static int fakePlayerWordForAll() {
 
 /*----------------------------------------------------------------------*/
 static void errorButAfterAll(int butWordIndex) {
-    Parameter *messageParameters = newParameterArray();
+    Parameter *messageParameters = newTemporaryParameterArray();
     addParameterForWord(messageParameters, butWordIndex);
     addParameterForWord(messageParameters, fakePlayerWordForAll());
     printMessageWithParameters(M_BUT_ALL, messageParameters);
@@ -277,13 +278,13 @@ static int getPronounInstances(int word, Parameter instanceParameters[]) {
 
 /*----------------------------------------------------------------------*/
 static bool inOpaqueContainer(int originalInstance) {
-    int instance = admin[originalInstance].location;
+    int instance = admin.location[originalInstance];
 
     while (isAContainer(instance)) {
         // TODO : isOpaque()
         if (getInstanceAttribute(instance, OPAQUEATTRIBUTE))
             return true;
-        instance = admin[instance].location;
+        instance = admin.location[instance];
     }
     return false;
 }
@@ -338,19 +339,6 @@ static bool lastPossibleNoun(int wordIndex) {
 }
 
 
-/*----------------------------------------------------------------------*/
-static void updateWithReferences(Parameter result[], int wordIndex, Aint *(*referenceFinder)(int wordIndex)) {
-    static Parameter *references = NULL; /* Instances referenced by a word */
-    references = ensureParameterArrayAllocated(references);
-
-    copyReferencesToParameterArray(referenceFinder(wordIndex), references);
-    if (lengthOfParameterArray(result) == 0)
-        copyParameterArray(result, references);
-    else
-        intersectParameterArrays(result, references);
-}
-
-
 /*----------------------------------------------------------------------*/
 static void filterOutNonReachable(Parameter filteredCandidates[], bool (*reachable)(int)) {
     int i;
@@ -372,22 +360,90 @@ static void filterOutNonReachable(Parameter filteredCandidates[], bool (*reachab
  * maybe 'all' is the only inferred?
  */
 
+/*----------------------------------------------------------------------*/
+/* Is the container, or any container it is in, opaque? Remembered in
+   'opaque' for all containers on the way, 0 meaning not yet known, so
+   that candidates in the same containers are not walked again. */
+static bool opaqueFrom(int container, char opaque[]) {
+    int outer;
+    bool result;
+
+    if (!isAContainer(container))
+        return false;
+    if (opaque[container] != 0)
+        return opaque[container] == 2;
+
+    outer = admin.location[container];
+    result = getInstanceAttribute(container, OPAQUEATTRIBUTE) || opaqueFrom(outer, opaque);
+    opaque[container] = result?2:1;
+    return result;
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Find if the candidates are reachable, like reachable() does, but for
+   all of them in one go. Things are here if their location is the
+   current location or one it is nested in, which are found only once. */
+static void findReachableCandidates(Parameter candidates[], bool reachables[]) {
+    Aint *hereLocations;
+    char *opaque;
+    int hereCount = 0;
+    int location;
+    int i, l;
+
+    if (current.location == 0 || !isALocation(current.location)) {
+        for (i = 0; !isEndOfArray(&candidates[i]); i++)
+            reachables[i] = candidates[i].instance != 0 && reachable(candidates[i].instance);
+        return;
+    }
+
+    hereLocations = allocate((header->instanceMax+1)*sizeof(Aint));
+    for (location = current.location; location != 0 && hereCount <= header->instanceMax; location = admin.location[location])
+        hereLocations[hereCount++] = location;
+    opaque = allocate(header->instanceMax+1);
+
+    for (i = 0; !isEndOfArray(&candidates[i]); i++) {
+        int instance = candidates[i].instance;
+        reachables[i] = false;
+        if (instance == 0)
+            continue;
+        if (isLiteral(instance) || isALocation(instance) || !isA(instance, THING))
+            reachables[i] = reachable(instance);
+        else {
+            location = locationOf(instance);
+            for (l = 0; l < hereCount; l++)
+                if (hereLocations[l] == location) {
+                    reachables[i] = !opaqueFrom(admin.location[instance], opaque);
+                    break;
+                }
+        }
+    }
+    deallocate(opaque);
+    deallocate(hereLocations);
+}
+
+
 /*----------------------------------------------------------------------*/
 static void disambiguateCandidatesForPosition(ParameterPosition parameterPositions[], int position, Parameter candidates[]) {
     int i;
-    Parameter *parameters = newParameterArray();
+    Parameter *parameters = newTemporaryParameterArray();
+    bool *reachables = allocateTemporary((lengthOfParameterArray(candidates)+1)*sizeof(bool));
 
     convertPositionsToParameters(parameterPositions, parameters);
+    findReachableCandidates(candidates, reachables);
+    startRememberingChecks();
     for (i = 0; !isEndOfArray(&candidates[i]); i++) {
         if (candidates[i].instance != 0) { /* Already empty? */
             copyParameter(&parameters[position], &candidates[i]);
             // DISAMBIGUATION!!
-            if (!reachable(candidates[i].instance) || !possible(current.verb, parameters, parameterPositions))
+            if (!reachables[i] || !possible(current.verb, parameters, parameterPositions))
                 candidates[i].instance = 0; /* Then remove this candidate from list */
         }
     }
+    stopRememberingChecks();
     compressParameterArray(candidates);
     freeParameterArray(parameters);
+    deallocate(reachables);
 }
 
 
@@ -460,7 +516,7 @@ static void parseReference(Parameter parameters[]) {
 static void getPreviousMultipleParameters(Parameter parameters[]) {
     int i;
     for (i = 0; !isEndOfArray(&previousMultipleParameters[i]); i++) {
-        parameters[i].candidates = ensureParameterArrayAllocated(parameters[i].candidates);
+        parameters[i].candidates = ensureTemporaryParameterArrayAllocated(parameters[i].candidates);
         setEndOfArray(&parameters[i].candidates[0]); /* No candidates */
         if (!reachable(previousMultipleParameters[i].instance))
             parameters[i].instance = 0;
@@ -483,7 +539,7 @@ static void parseReferenceToPreviousMultipleParameters(Parameter parameters[]) {
 
 /*----------------------------------------------------------------------*/
 static bool parseOneParameter(Parameter parameters[], int parameterIndex) {
-    Parameter *parameter = newParameterArray();
+    Parameter *parameter = newTemporaryParameterArray();
 
     // TODO Maybe this should go in the complex()?
     if (isThemWord(currentWordIndex) && (!isPronounWord(currentWordIndex) ||
@@ -569,7 +625,7 @@ static void simpleParameterParser(Parameter parameters[]) {
 static void parseExceptions(ParameterPosition *parameterPosition, ParameterParser simpleParameterParser) {
     int exceptWordIndex = currentWordIndex;
     currentWordIndex++;
-    parameterPosition->exceptions = ensureParameterArrayAllocated(parameterPosition->exceptions);
+    parameterPosition->exceptions = ensureTemporaryParameterArrayAllocated(parameterPosition->exceptions);
     simpleParameterParser(parameterPosition->exceptions);
     if (lengthOfParameterArray(parameterPosition->exceptions) == 0)
         errorAfterExcept(exceptWordIndex);
@@ -588,7 +644,7 @@ static void parseExceptions(ParameterPosition *parameterPosition, ParameterParse
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 static void complexParameterParserDelegate(ParameterPosition *parameterPosition, ParameterParser simpleParameterParser) {
-    parameterPosition->parameters = ensureParameterArrayAllocated(parameterPosition->parameters);
+    parameterPosition->parameters = ensureTemporaryParameterArrayAllocated(parameterPosition->parameters);
 
     parameterPosition->all = false;
     parameterPosition->them = false;
@@ -737,7 +793,7 @@ static bool multipleAllowed(Aword flags) {
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 static void parseParameterPosition(ParameterPosition *parameterPosition, Aword flags, void (*complexReferencesParser)(ParameterPosition *parameterPosition)) {
-    parameterPosition->parameters = ensureParameterArrayAllocated(parameterPosition->parameters);
+    parameterPosition->parameters = ensureTemporaryParameterArrayAllocated(parameterPosition->parameters);
 
     complexReferencesParser(parameterPosition);
     if (lengthOfParameterArray(parameterPosition->parameters) == 0) /* No object!? */
@@ -966,13 +1022,45 @@ static void matchPronoun(Parameter *parameter) {
 }
 
 
+/*----------------------------------------------------------------------*/
+/* Narrow the candidates down to the instances also referenced by the
+   word. If there are none left the word starts over with its own
+   references, which then also give the order of the candidates. */
+static void updateWithReferences(Bitset *candidates, Aint **orderedReferences, Bitset *references, Aint wordReferences[]) {
+    if (countBitset(candidates) == 0) {
+        *orderedReferences = wordReferences;
+        addReferencesToBitset(candidates, wordReferences);
+    } else {
+        clearBitset(references);
+        addReferencesToBitset(references, wordReferences);
+        intersectBitsets(candidates, references);
+    }
+}
+
+
 /*----------------------------------------------------------------------*/
 static void matchNounPhrase(Parameter *parameter, ReferencesFinder adjectiveReferencesFinder, ReferencesFinder nounReferencesFinder) {
-    int i;
+    Bitset *candidates = newBitset(header->instanceMax+1);
+    Bitset *references = newBitset(header->instanceMax+1);
+    Aint *orderedReferences = NULL;
+    Parameter candidate;
+    int i, count = 0;
 
     for (i = parameter->firstWord; i < parameter->lastWord; i++)
-        updateWithReferences(parameter->candidates, i, adjectiveReferencesFinder);
-    updateWithReferences(parameter->candidates, parameter->lastWord, nounReferencesFinder);
+        updateWithReferences(candidates, &orderedReferences, references, adjectiveReferencesFinder(i));
+    updateWithReferences(candidates, &orderedReferences, references, nounReferencesFinder(parameter->lastWord));
+
+    memset(&candidate, 0, sizeof(candidate));
+    candidate.firstWord = EOF; /* Ensure that there is no word that can be used */
+    for (i = 0; orderedReferences != NULL && !isEndOfArray(&orderedReferences[i]); i++)
+        if (inBitset(candidates, orderedReferences[i])) {
+            candidate.instance = orderedReferences[i];
+            copyParameter(&parameter->candidates[count++], &candidate);
+        }
+    setEndOfArray(&parameter->candidates[count]);
+
+    freeBitset(references);
+    freeBitset(candidates);
 }
 
 
@@ -1005,7 +1093,7 @@ static void findCandidates(Parameter parameters[], void (*instanceMatcher)(Param
     int i;
 
     for (i = 0; i < lengthOfParameterArray(parameters); i++) {
-        parameters[i].candidates = ensureParameterArrayAllocated(parameters[i].candidates);
+        parameters[i].candidates = ensureTemporaryParameterArrayAllocated(parameters[i].candidates);
         instanceMatcher(&parameters[i]);
         parameters[i].candidates[0].isPronoun = parameters[i].isPronoun;
     }
@@ -1303,12 +1391,8 @@ static void disambiguate(ParameterPosition parameterPositions[], ElementEntry *e
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 static void try(Parameter parameters[], Parameter multipleParameters[]) {
     ElementEntry *element;      /* Pointer to element list */
-    static ParameterPosition *parameterPositions = NULL;
-    if (parameterPositions != NULL)
-        deallocateParameterPositions(parameterPositions);
+    ParameterPosition *parameterPositions = allocateTemporary(sizeof(ParameterPosition)*(MAXPARAMS+1));
 
-    // TODO newParameterPositionArray()!!!! Or even reallocatePP.. or cleanPP..
-    parameterPositions = allocate(sizeof(ParameterPosition)*(MAXPARAMS+1));
     parameterPositions[0].endOfList = true;
 
     element = parseInput(parameterPositions);
@@ -1321,7 +1405,6 @@ static void try(Parameter parameters[], Parameter multipleParameters[]) {
     convertMultipleCandidatesToMultipleParameters(parameterPositions, multipleParameters);
 
     deallocateParameterPositions(parameterPositions);
-    parameterPositions = NULL;
 }
 
 
@@ -1419,11 +1502,9 @@ static void parseInstanceCommand(Parameter parameters[], Parameter multipleParam
 
 /*======================================================================*/
 void parse(void) {
-    /* longjmp's ahead so these need to survive to not leak memory */
-    static Parameter *parameters = NULL;
-    static Parameter *multipleParameters = NULL;
-    parameters = ensureParameterArrayAllocated(parameters);
-    multipleParameters = ensureParameterArrayAllocated(multipleParameters);
+    /* Temporaries, since errors longjmp ahead past the end */
+    Parameter *parameters = newTemporaryParameterArray();
+    Parameter *multipleParameters = newTemporaryParameterArray();
 
     if (endOfWords(currentWordIndex)) {
         currentWordIndex = 0;
@@ -1459,7 +1540,5 @@ void parse(void) {
         clearParameterArray(previousMultipleParameters);
 
     freeParameterArray(parameters);
-    parameters = NULL;
     freeParameterArray(multipleParameters);
-    multipleParameters = NULL;
 }
@@ -0,0 +1,213 @@
+/*----------------------------------------------------------------------*\
+
+  predecode
+
+  Translation of the Acode into decoded instructions.
+
+  Every address gets its own decoded instruction, so any address the
+  interpreter may continue at, e.g. after a scan for a matching ENDIF,
+  is valid. An instruction is decoded from its own address and as
+  many following instructions as can be folded into it, and 'next'
+  tells where to continue.
+
+  Instructions that are not decoded here (D_OTHER) have 'next' at
+  their own address, they are left to the Acode interpreter which
+  fetches them again.
+
+\*----------------------------------------------------------------------*/
+#include "predecode.h"
+
+/* IMPORTS */
+#include "acode.h"
+#include "memory.h"
+#include "branches.h"
+
+
+/* PUBLIC DATA */
+DecodedInstruction *decodedInstructions = NULL;
+
+
+/* PRIVATE DATA */
+static DecodedOpcode curvarOpcodes[V_MAX_INSTANCE+1] = {
+    [V_PARAM] = D_PARAM,
+    [V_CURLOC] = D_CURLOC,
+    [V_CURACT] = D_CURACT,
+    [V_CURVRB] = D_CURVRB,
+    [V_CURRENT_INSTANCE] = D_CURINS,
+    [V_SCORE] = D_CURSCORE,
+    [V_MAX_INSTANCE] = D_MAXINSTANCE
+};
+
+static DecodedOpcode stmopOpcodes[I_DUPSTR+1] = {
+    [I_PRINT] = D_PRINT,
+    [I_SAY] = D_SAY,
+    [I_SAYINT] = D_SAYINT,
+    [I_DESCRIBE] = D_DESCRIBE,
+    [I_ATTRIBUTE] = D_ATTRIBUTE,
+    [I_ATTRSTR] = D_ATTRSTR,
+    [I_MAKE] = D_MAKE,
+    [I_SET] = D_SET,
+    [I_LOCATE] = D_LOCATE,
+    [I_WHERE] = D_WHERE,
+    [I_LOCATION] = D_LOCATION,
+    [I_HERE] = D_HERE,
+    [I_NEARBY] = D_NEARBY,
+    [I_AT] = D_AT,
+    [I_IN] = D_IN,
+    [I_ISA] = D_ISA,
+    [I_SCHEDULE] = D_SCHEDULE,
+    [I_CANCEL] = D_CANCEL,
+    [I_IF] = D_IF,
+    [I_ELSE] = D_ELSE,
+    [I_ENDIF] = D_ENDIF,
+    [I_AND] = D_AND,
+    [I_OR] = D_OR,
+    [I_NOT] = D_NOT,
+    [I_EQ] = D_EQ,
+    [I_NE] = D_NE,
+    [I_LT] = D_LT,
+    [I_GT] = D_GT,
+    [I_LE] = D_LE,
+    [I_GE] = D_GE,
+    [I_PLUS] = D_PLUS,
+    [I_MINUS] = D_MINUS,
+    [I_INCR] = D_INCR,
+    [I_DECR] = D_DECR,
+    [I_DEPEND] = D_DEPEND,
+    [I_DEPCASE] = D_DEPCASE,
+    [I_DEPEXEC] = D_DEPEXEC,
+    [I_DEPELSE] = D_DEPELSE,
+    [I_ENDDEP] = D_ENDDEP,
+    [I_FRAME] = D_FRAME,
+    [I_GETLOCAL] = D_GETLOCAL,
+    [I_SETLOCAL] = D_SETLOCAL,
+    [I_ENDFRAME] = D_ENDFRAME,
+    [I_LOOP] = D_LOOP,
+    [I_LOOPNEXT] = D_LOOPNEXT,
+    [I_LOOPEND] = D_LOOPEND,
+    [I_DUP] = D_DUP,
+    [I_POP] = D_POP,
+    [I_RETURN] = D_RETURN
+};
+
+/* How many values the instruction pops before it pushes anything,
+   which is how many constants can be folded into it */
+static int operandCounts[DECODED_OPCODES] = {
+    [D_PARAM] = 1,
+    [D_PRINT] = 2, [D_SAY] = 2, [D_SAYINT] = 1, [D_DESCRIBE] = 1,
+    [D_ATTRIBUTE] = 2, [D_ATTRSTR] = 2, [D_MAKE] = 3, [D_SET] = 3,
+    [D_LOCATE] = 2, [D_WHERE] = 2, [D_LOCATION] = 1, [D_HERE] = 2,
+    [D_NEARBY] = 2, [D_AT] = 3, [D_IN] = 3, [D_ISA] = 2,
+    [D_SCHEDULE] = 3, [D_CANCEL] = 1,
+    [D_IF] = 1,
+    [D_AND] = 2, [D_OR] = 2, [D_NOT] = 1, [D_EQ] = 2, [D_NE] = 2,
+    [D_LT] = 2, [D_GT] = 2, [D_LE] = 2, [D_GE] = 2,
+    [D_PLUS] = 2, [D_MINUS] = 2, [D_INCR] = 2, [D_DECR] = 2,
+    [D_DEPEXEC] = 1,
+    [D_FRAME] = 1, [D_GETLOCAL] = 2, [D_SETLOCAL] = 3,
+    [D_LOOP] = 2, [D_LOOPEND] = 2,
+    [D_POP] = 1
+};
+
+/* Instructions whose result can be tested directly by a following IF */
+static bool isTest[DECODED_OPCODES] = {
+    [D_ATTRIBUTE] = true, [D_HERE] = true, [D_NEARBY] = true,
+    [D_AT] = true, [D_IN] = true, [D_ISA] = true,
+    [D_AND] = true, [D_OR] = true, [D_NOT] = true,
+    [D_EQ] = true, [D_NE] = true, [D_LT] = true, [D_GT] = true,
+    [D_LE] = true, [D_GE] = true
+};
+
+
+/*----------------------------------------------------------------------*/
+static bool isConstant(Aaddr adr) {
+    return I_CLASS(memory[adr]) == (Aword)C_CONST;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool isInstruction(Aaddr adr, InstClass instruction) {
+    return I_CLASS(memory[adr]) == (Aword)C_STMOP && I_OP(memory[adr]) == instruction;
+}
+
+
+/*----------------------------------------------------------------------*/
+static DecodedOpcode opcodeOf(Aword instruction) {
+    Aint op = I_OP(instruction);
+
+    switch (I_CLASS(instruction)) {
+    case C_CONST:
+        return D_PUSH;
+    case C_CURVAR:
+        if (op >= 0 && op <= V_MAX_INSTANCE)
+            return curvarOpcodes[op];
+        break;
+    case C_STMOP:
+        if (op >= 0 && op <= I_DUPSTR)
+            return stmopOpcodes[op];
+        break;
+    }
+    return D_OTHER;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void decodeInstruction(Aaddr adr, DecodedInstruction *decoded) {
+    Aaddr opAdr = adr;
+    int constants = 0;
+    int i;
+
+    /* Find the instruction using the constants pushed from here */
+    while (opAdr < memTop && isConstant(opAdr) && constants <= MAX_FOLDED_OPERANDS) {
+        opAdr++;
+        constants++;
+    }
+    if (constants > 0 && (opAdr >= memTop || constants > operandCounts[opcodeOf(memory[opAdr])])) {
+        decoded->opcode = D_PUSH;
+        decoded->operand[0] = I_OP(memory[adr]);
+        decoded->next = adr+1;
+        return;
+    }
+
+    decoded->opcode = opcodeOf(memory[opAdr]);
+    decoded->operands = constants;
+    for (i = 0; i < constants; i++)
+        decoded->operand[i] = I_OP(memory[adr+i]);
+
+    if (decoded->opcode == D_OTHER) {
+        decoded->next = opAdr;
+        return;
+    }
+
+    decoded->next = opAdr+1;
+    if (decoded->opcode == D_IF || decoded->opcode == D_ELSE)
+        decoded->target = branchTarget(opAdr);
+    else if (isTest[decoded->opcode] && opAdr+1 < memTop && isInstruction(opAdr+1, I_IF)) {
+        decoded->thenIf = true;
+        decoded->next = opAdr+2;
+        decoded->target = branchTarget(opAdr+1);
+    }
+}
+
+
+/*======================================================================*/
+void predecodeInstructions(void) {
+    Aaddr adr;
+
+    freeDecodedInstructions();
+
+    /* Extra ones to stop anything running off the end */
+    decodedInstructions = allocate((memTop+2)*sizeof(DecodedInstruction));
+    for (adr = 0; adr < memTop; adr++)
+        decodeInstruction(adr, &decodedInstructions[adr]);
+    decodedInstructions[memTop].opcode = D_OUTSIDE;
+    decodedInstructions[memTop+1].opcode = D_OUTSIDE;
+}
+
+
+/*======================================================================*/
+void freeDecodedInstructions(void) {
+    if (decodedInstructions != NULL)
+        deallocate(decodedInstructions);
+    decodedInstructions = NULL;
+}
@@ -0,0 +1,64 @@
+#ifndef PREDECODE_H_
+#define PREDECODE_H_
+/*----------------------------------------------------------------------*\
+
+  predecode
+
+  The Acode translated, once after loading, into an array of decoded
+  instructions indexed on the same addresses as the Acode, so that
+  the interpreter does not have to decode the same instructions over
+  and over again.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+#define MAX_FOLDED_OPERANDS 3
+
+
+/* TYPES */
+typedef enum DecodedOpcode {
+    D_OTHER,                    /* Executed by the Acode interpreter */
+    D_OUTSIDE,                  /* Outside the program */
+    D_PUSH,
+    D_PARAM, D_CURLOC, D_CURACT, D_CURVRB, D_CURINS, D_CURSCORE, D_MAXINSTANCE,
+    D_PRINT, D_SAY, D_SAYINT, D_DESCRIBE,
+    D_ATTRIBUTE, D_ATTRSTR, D_MAKE, D_SET,
+    D_LOCATE, D_WHERE, D_LOCATION, D_HERE, D_NEARBY, D_AT, D_IN, D_ISA,
+    D_SCHEDULE, D_CANCEL,
+    D_IF, D_ELSE, D_ENDIF,
+    D_AND, D_OR, D_NOT, D_EQ, D_NE, D_LT, D_GT, D_LE, D_GE,
+    D_PLUS, D_MINUS, D_INCR, D_DECR,
+    D_DEPEND, D_DEPCASE, D_DEPEXEC, D_DEPELSE, D_ENDDEP,
+    D_FRAME, D_GETLOCAL, D_SETLOCAL, D_ENDFRAME,
+    D_LOOP, D_LOOPNEXT, D_LOOPEND,
+    D_DUP, D_POP, D_RETURN,
+    DECODED_OPCODES
+} DecodedOpcode;
+
+/* Constants pushed immediately before an instruction are folded into
+   it as operands, in the order they were pushed, and a test directly
+   followed by an IF is made into one instruction which branches on
+   the result instead of pushing it. */
+typedef struct DecodedInstruction {
+    DecodedOpcode opcode;
+    int operands;               /* Number of folded operands */
+    Aword operand[MAX_FOLDED_OPERANDS]; /* Also the value for a PUSH */
+    bool thenIf;                /* The result is consumed by an IF */
+    Aaddr next;                 /* Address of following instruction */
+    Aaddr target;               /* IF or ELSE branch target, 0 if unknown */
+} DecodedInstruction;
+
+
+/* DATA */
+extern DecodedInstruction *decodedInstructions;
+
+
+/* FUNCTIONS */
+extern void predecodeInstructions(void);
+extern void freeDecodedInstructions(void);
+
+#endif /* PREDECODE_H_ */
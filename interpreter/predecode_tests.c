@@ -0,0 +1,116 @@
+#include <cgreen/cgreen.h>
+#include <cgreen/mocks.h>
+
+#include "predecode.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "instance.mock"
+#include "branches.mock"
+
+
+static Aaddr code;
+
+static void given_code(Aword instructions[], int length) {
+    int headerSize = sizeof(ACodeHeader)/sizeof(Aword);
+
+    memory = allocate((headerSize+length+1)*sizeof(Aword));
+    header = (ACodeHeader *)memory;
+    memTop = headerSize+length;
+
+    code = headerSize;
+    memcpy(&memory[code], instructions, length*sizeof(Aword));
+}
+
+
+Describe(Predecode);
+BeforeEach(Predecode) {
+    always_expect(branchTarget, will_return(0));
+}
+AfterEach(Predecode) {
+    freeDecodedInstructions();
+    free(memory);
+    memory = NULL;
+}
+
+
+Ensure(Predecode, folds_pushed_constants_into_the_instruction) {
+    Aword instructions[] = {
+        CONSTANT(4), CONSTANT(7), INSTRUCTION(I_ATTRIBUTE),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    predecodeInstructions();
+
+    assert_that(decodedInstructions[code].opcode, is_equal_to(D_ATTRIBUTE));
+    assert_that(decodedInstructions[code].operands, is_equal_to(2));
+    assert_that(decodedInstructions[code].operand[0], is_equal_to(4));
+    assert_that(decodedInstructions[code].operand[1], is_equal_to(7));
+    assert_that(decodedInstructions[code].next, is_equal_to(code+3));
+    assert_that(decodedInstructions[code+1].opcode, is_equal_to(D_ATTRIBUTE));
+    assert_that(decodedInstructions[code+1].operands, is_equal_to(1));
+}
+
+Ensure(Predecode, pushes_sign_extended_constants_that_can_not_be_folded) {
+    Aword instructions[] = {
+        CONSTANT(0x0fffffff), CONSTANT(2), CONSTANT(3), INSTRUCTION(I_PLUS),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    predecodeInstructions();
+
+    assert_that(decodedInstructions[code].opcode, is_equal_to(D_PUSH));
+    assert_that(decodedInstructions[code].operand[0], is_equal_to((Aword)-1));
+    assert_that(decodedInstructions[code].next, is_equal_to(code+1));
+    assert_that(decodedInstructions[code+1].opcode, is_equal_to(D_PLUS));
+    assert_that(decodedInstructions[code+1].operands, is_equal_to(2));
+}
+
+Ensure(Predecode, makes_a_test_followed_by_if_into_one_instruction) {
+    Aword instructions[] = {
+        CURVAR(V_CURLOC), CONSTANT(3), INSTRUCTION(I_EQ), INSTRUCTION(I_IF),
+        INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    predecodeInstructions();
+
+    assert_that(decodedInstructions[code].opcode, is_equal_to(D_CURLOC));
+    assert_that(decodedInstructions[code+1].opcode, is_equal_to(D_EQ));
+    assert_that(decodedInstructions[code+1].thenIf, is_true);
+    assert_that(decodedInstructions[code+1].next, is_equal_to(code+4));
+    assert_that(decodedInstructions[code+3].opcode, is_equal_to(D_IF));
+    assert_that(decodedInstructions[code+3].thenIf, is_false);
+}
+
+Ensure(Predecode, takes_branch_target_of_the_if) {
+    Aword instructions[] = {
+        CONSTANT(1), INSTRUCTION(I_NOT), INSTRUCTION(I_IF),
+        INSTRUCTION(I_ENDIF),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+    expect(branchTarget, when(instructionAddress, is_equal_to(code+2)),
+           will_return(code+4));
+
+    predecodeInstructions();
+
+    assert_that(decodedInstructions[code].target, is_equal_to(code+4));
+}
+
+Ensure(Predecode, leaves_other_instructions_to_the_interpreter) {
+    Aword instructions[] = {
+        INSTRUCTION(I_LOOK),
+        INSTRUCTION(I_RETURN)
+    };
+    given_code(instructions, ASIZE(instructions));
+
+    predecodeInstructions();
+
+    assert_that(decodedInstructions[code].opcode, is_equal_to(D_OTHER));
+    assert_that(decodedInstructions[code].next, is_equal_to(code));
+    assert_that(decodedInstructions[memTop+1].opcode, is_equal_to(D_OUTSIDE));
+}
@@ -0,0 +1,456 @@
+/*----------------------------------------------------------------------*\
+
+  profile
+
+  Instruction level profiling in Arun. When -profile is given every
+  executed instruction is counted per opcode, code address and source
+  line. The time from the start of one instruction to the start of
+  the next is charged to the first, so an instruction that calls the
+  interpreter (e.g. a DESCRIBE) is only charged for its own work, the
+  code it calls being charged separately.
+
+  Source lines are known from the LINE instructions, which are only
+  generated when the game is compiled with -debug, and indexed using
+  the source line table. At the end a sorted report is written to
+  <game>.a3p and the same counts as XML to <game>.a3p.xml.
+
+\*----------------------------------------------------------------------*/
+#include "profile.h"
+
+/* IMPORTS */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "acode.h"
+#include "memory.h"
+#include "lists.h"
+#include "args.h"
+#include "debug.h"
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <x86intrin.h>
+#define TIME_UNIT "cycles"
+#define now() __rdtsc()
+#else
+#include <time.h>
+#define TIME_UNIT "clock ticks"
+#define now() clock()
+#endif
+
+
+/* PRIVATE CONSTANTS */
+#define CURVAR_OPCODES (V_MAX_INSTANCE+1)
+#define STMOP_OPCODES (I_DUPSTR+1)
+#define FIRST_CURVAR 1
+#define FIRST_STMOP (FIRST_CURVAR+CURVAR_OPCODES)
+#define UNKNOWN_OPCODE (FIRST_STMOP+STMOP_OPCODES)
+#define OPCODES (UNKNOWN_OPCODE+1)
+
+#define MAX_DEPTH 1002          /* The interpreter allows 1000 */
+#define REPORTED_LINES 30
+#define REPORTED_ADDRESSES 30
+
+
+/* PRIVATE TYPES */
+typedef struct ProfileCount {
+    unsigned long count;
+    unsigned long long time;
+} ProfileCount;
+
+typedef struct Executing {
+    bool valid;
+    int opcode;
+    Aaddr address;
+    int line;                   /* Index in the source line table */
+} Executing;
+
+
+/* PRIVATE DATA */
+static char *curvarNames[CURVAR_OPCODES] = {
+    "PARAM", "CURLOC", "CURACT", "CURVRB", "CURSCORE", "CURINS", "MAXINSTANCE"
+};
+
+static char *stmopNames[STMOP_OPCODES] = {
+    "LINE", "PRINT", "STYLE", "QUIT", "LOOK", "SAVE", "RESTORE", "LIST",
+    "EMPTY", "SCORE", "VISITS", "SCHEDULE", "CANCEL", "LOCATE", "MAKE",
+    "SET", "SETSTR", "SETSET", "NEWSET", "ATTRIBUTE", "ATTRSTR", "ATTRSET",
+    "UNION", "GETSTR", "INCR", "DECR", "INCLUDE", "EXCLUDE", "SETSIZE",
+    "SETMEMB", "CONTSIZE", "CONTMEMB", "USE", "STOP", "AT", "IN", "INSET",
+    "HERE", "NEARBY", "NEAR", "WHERE", "LOCATION", "DESCRIBE", "SAY",
+    "SAYINT", "SAYSTR", "IF", "ELSE", "ENDIF", "AND", "OR", "NE", "EQ",
+    "STREQ", "STREXACT", "LE", "GE", "LT", "GT", "PLUS", "MINUS", "MULT",
+    "DIV", "NOT", "UMINUS", "RND", "RETURN", "SYSTEM", "RESTART", "BTW",
+    "CONTAINS", "DUP", "DEPEND", "DEPCASE", "DEPEXEC", "DEPELSE", "ENDDEP",
+    "ISA", "FRAME", "SETLOCAL", "GETLOCAL", "ENDFRAME", "LOOP", "LOOPNEXT",
+    "LOOPEND", "SUM", "MAX", "MIN", "COUNT", "SHOW", "PLAY", "CONCAT",
+    "STRIP", "POP", "TRANSCRIPT", "DUPSTR"
+};
+
+static ProfileCount opcodeCounts[OPCODES];
+static ProfileCount *addressCounts = NULL;
+static int *addressLine = NULL; /* Line last executing each address */
+static int addressMax = 0;
+
+static SourceLineEntry *lines = NULL;
+static int lineCount = 0;       /* Index lineCount is for no known line */
+static ProfileCount *lineCounts = NULL;
+static int *lineHash = NULL;    /* Line index+1 hashed on file and line */
+static int lineHashMask = 0;
+
+static Executing executing;
+static Executing callers[MAX_DEPTH];
+static unsigned long long started;
+
+
+/*----------------------------------------------------------------------*/
+static char *opcodeName(int opcode) {
+    if (opcode == 0)
+        return "PUSH";
+    else if (opcode < FIRST_STMOP)
+        return curvarNames[opcode-FIRST_CURVAR];
+    else if (opcode < UNKNOWN_OPCODE)
+        return stmopNames[opcode-FIRST_STMOP];
+    else
+        return "?";
+}
+
+
+/*----------------------------------------------------------------------*/
+static int opcodeOf(Aword instruction) {
+    int op = I_OP(instruction);
+
+    switch (I_CLASS(instruction)) {
+    case C_CONST:
+        return 0;
+    case C_CURVAR:
+        if (op >= 0 && op < CURVAR_OPCODES)
+            return FIRST_CURVAR+op;
+        break;
+    case C_STMOP:
+        if (op >= 0 && op < STMOP_OPCODES)
+            return FIRST_STMOP+op;
+        break;
+    }
+    return UNKNOWN_OPCODE;
+}
+
+
+/*----------------------------------------------------------------------*/
+static int hashOfLine(int file, int line) {
+    return (file*7919 + line) & lineHashMask;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexSourceLines(void) {
+    int size = 1;
+    int i;
+
+    if (header->sourceLineTable != 0) {
+        lines = pointerTo(header->sourceLineTable);
+        for (lineCount = 0; !isEndOfArray(&lines[lineCount]); lineCount++)
+            ;
+    }
+    lineCounts = allocate((lineCount+1)*sizeof(ProfileCount));
+
+    while (size < 2*lineCount)
+        size *= 2;
+    lineHashMask = size-1;
+    lineHash = allocate(size*sizeof(int));
+    for (i = 0; i < lineCount; i++) {
+        int hash = hashOfLine(lines[i].file, lines[i].line);
+        while (lineHash[hash] != 0)
+            hash = (hash+1) & lineHashMask;
+        lineHash[hash] = i+1;
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static int lineIndex(int file, int line) {
+    int hash;
+
+    if (lineCount == 0)
+        return lineCount;
+    for (hash = hashOfLine(file, line); lineHash[hash] != 0; hash = (hash+1) & lineHashMask) {
+        SourceLineEntry *entry = &lines[lineHash[hash]-1];
+        if (entry->file == file && entry->line == line)
+            return lineHash[hash]-1;
+    }
+    return lineCount;
+}
+
+
+/*======================================================================*/
+/* Counts are kept over restarts, so only the first call initialises */
+void initProfile(void) {
+    if (addressCounts != NULL)
+        return;
+    memset(opcodeCounts, 0, sizeof(opcodeCounts));
+    addressMax = memTop;
+    addressCounts = allocate((addressMax+1)*sizeof(ProfileCount));
+    addressLine = allocate((addressMax+1)*sizeof(int));
+    indexSourceLines();
+    executing.valid = false;
+    executing.line = lineCount;
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Charge the time since it started to the executing instruction */
+static void charge(unsigned long long time) {
+    unsigned long long spent = time - started;
+
+    if (!executing.valid)
+        return;
+    opcodeCounts[executing.opcode].time += spent;
+    addressCounts[executing.address].time += spent;
+    lineCounts[executing.line].time += spent;
+}
+
+
+/*======================================================================*/
+/* The interpreter is entered at call depth 'depth' (1 is outermost) */
+void profileEnter(int depth) {
+    unsigned long long time = now();
+
+    if (depth > 1 && depth < MAX_DEPTH) {
+        charge(time);
+        callers[depth] = executing;
+    }
+    executing.valid = false;
+    executing.line = lineCount;
+    started = time;
+}
+
+
+/*======================================================================*/
+void profileInstruction(Aaddr address, Aword instruction) {
+    unsigned long long time = now();
+
+    charge(time);
+
+    if (address > addressMax)
+        return;
+    executing.valid = true;
+    executing.opcode = opcodeOf(instruction);
+    executing.address = address;
+
+    opcodeCounts[executing.opcode].count++;
+    addressCounts[address].count++;
+    addressLine[address] = executing.line;
+    lineCounts[executing.line].count++;
+    started = time;
+}
+
+
+/*======================================================================*/
+void profileLine(int file, int line) {
+    executing.line = lineIndex(file, line);
+}
+
+
+/*======================================================================*/
+void profileExit(int depth) {
+    unsigned long long time = now();
+
+    charge(time);
+    if (depth > 1 && depth < MAX_DEPTH)
+        executing = callers[depth];
+    else
+        executing.valid = false;
+    started = time;
+}
+
+
+/* Sorting of the counts, most time first */
+static ProfileCount *sortedCounts;
+
+/*----------------------------------------------------------------------*/
+static int compareCounts(const void *a, const void *b) {
+    ProfileCount *countA = &sortedCounts[*(int *)a];
+    ProfileCount *countB = &sortedCounts[*(int *)b];
+
+    if (countA->time != countB->time)
+        return countA->time < countB->time ? 1 : -1;
+    if (countA->count != countB->count)
+        return countA->count < countB->count ? 1 : -1;
+    return *(int *)a - *(int *)b;
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Indices of the counts that were executed, most time first */
+static int sortCounts(ProfileCount counts[], int size, int **indices) {
+    int used = 0;
+    int i;
+
+    *indices = allocate((size+1)*sizeof(int));
+    for (i = 0; i < size; i++)
+        if (counts[i].count != 0)
+            (*indices)[used++] = i;
+    sortedCounts = counts;
+    qsort(*indices, used, sizeof(int), compareCounts);
+    return used;
+}
+
+
+/*----------------------------------------------------------------------*/
+static char *lineName(int index) {
+    static char buffer[1000];
+
+    if (index == lineCount)
+        return "(unknown)";
+    sprintf(buffer, "%.900s:%d", sourceFileName(lines[index].file), lines[index].line);
+    return buffer;
+}
+
+
+/*----------------------------------------------------------------------*/
+static char *lineText(int index) {
+    char *text;
+
+    if (index == lineCount)
+        return "";
+    text = readSourceLine(lines[index].file, lines[index].line);
+    if (text == NULL)
+        return "";
+    text[strcspn(text, "\r\n")] = '\0';
+    return text;
+}
+
+
+/*----------------------------------------------------------------------*/
+static double percentOf(unsigned long long part, unsigned long long total) {
+    return total == 0 ? 0.0 : 100.0*part/total;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void writeReport(FILE *file) {
+    unsigned long long totalTime = 0;
+    unsigned long totalCount = 0;
+    int *sorted;
+    int used;
+    int i;
+
+    for (i = 0; i < OPCODES; i++) {
+        totalTime += opcodeCounts[i].time;
+        totalCount += opcodeCounts[i].count;
+    }
+
+    fprintf(file, "Profile of '%s': %lu instructions, %llu %s\n",
+            adventureName, totalCount, totalTime, TIME_UNIT);
+
+    fprintf(file, "\nOpcodes:\n");
+    fprintf(file, "  %-12s %12s %16s %7s\n", "opcode", "count", TIME_UNIT, "%");
+    used = sortCounts(opcodeCounts, OPCODES, &sorted);
+    for (i = 0; i < used; i++)
+        fprintf(file, "  %-12s %12lu %16llu %6.2f%%\n", opcodeName(sorted[i]),
+                opcodeCounts[sorted[i]].count, opcodeCounts[sorted[i]].time,
+                percentOf(opcodeCounts[sorted[i]].time, totalTime));
+    deallocate(sorted);
+
+    fprintf(file, "\nSource lines:\n");
+    if (lineCount == 0)
+        fprintf(file, "  (no source line information, compile the game with -debug)\n");
+    else {
+        used = sortCounts(lineCounts, lineCount+1, &sorted);
+        for (i = 0; i < used && i < REPORTED_LINES; i++) {
+            fprintf(file, "  %-30s %12lu %16llu %6.2f%%  ", lineName(sorted[i]),
+                    lineCounts[sorted[i]].count, lineCounts[sorted[i]].time,
+                    percentOf(lineCounts[sorted[i]].time, totalTime));
+            fprintf(file, "%s\n", lineText(sorted[i]));
+        }
+        deallocate(sorted);
+    }
+
+    fprintf(file, "\nCode addresses:\n");
+    used = sortCounts(addressCounts, addressMax+1, &sorted);
+    for (i = 0; i < used && i < REPORTED_ADDRESSES; i++)
+        fprintf(file, "  %8d %-12s %12lu %16llu %6.2f%%  %s\n", sorted[i],
+                opcodeName(opcodeOf(memory[sorted[i]])),
+                addressCounts[sorted[i]].count, addressCounts[sorted[i]].time,
+                percentOf(addressCounts[sorted[i]].time, totalTime),
+                lineName(addressLine[sorted[i]]));
+    deallocate(sorted);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void writeXmlString(FILE *file, char *string) {
+    char *s;
+
+    for (s = string; *s != '\0'; s++)
+        switch (*s) {
+        case '&': fputs("&amp;", file); break;
+        case '<': fputs("&lt;", file); break;
+        case '>': fputs("&gt;", file); break;
+        case '"': fputs("&quot;", file); break;
+        default: fputc(*s, file); break;
+        }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void writeXml(FILE *file) {
+    int i;
+
+    fprintf(file, "<?xml version=\"1.0\" encoding=\"ISO-8859-1\"?>\n");
+    fprintf(file, "<profile game=\"");
+    writeXmlString(file, adventureName);
+    fprintf(file, "\" unit=\"%s\">\n", TIME_UNIT);
+
+    for (i = 0; i < OPCODES; i++)
+        if (opcodeCounts[i].count != 0)
+            fprintf(file, "  <opcode name=\"%s\" count=\"%lu\" time=\"%llu\"/>\n",
+                    opcodeName(i), opcodeCounts[i].count, opcodeCounts[i].time);
+
+    for (i = 0; i < lineCount; i++)
+        if (lineCounts[i].count != 0) {
+            fprintf(file, "  <line file=\"");
+            writeXmlString(file, sourceFileName(lines[i].file));
+            fprintf(file, "\" line=\"%d\" count=\"%lu\" time=\"%llu\"/>\n",
+                    lines[i].line, lineCounts[i].count, lineCounts[i].time);
+        }
+
+    for (i = 0; i <= addressMax; i++)
+        if (addressCounts[i].count != 0) {
+            fprintf(file, "  <address address=\"%d\" opcode=\"%s\" count=\"%lu\" time=\"%llu\"",
+                    i, opcodeName(opcodeOf(memory[i])), addressCounts[i].count, addressCounts[i].time);
+            if (addressLine[i] != lineCount)
+                fprintf(file, " line=\"%d\"", lines[addressLine[i]].line);
+            fprintf(file, "/>\n");
+        }
+
+    fprintf(file, "</profile>\n");
+}
+
+
+/*======================================================================*/
+void writeProfile(void) {
+    char *fileName;
+    FILE *file;
+
+    if (addressCounts == NULL)
+        return;
+
+    fileName = allocate(strlen(adventureName)+strlen(".a3p.xml")+1);
+
+    sprintf(fileName, "%s.a3p", adventureName);
+    file = fopen(fileName, "w");
+    if (file != NULL) {
+        writeReport(file);
+        fclose(file);
+    }
+
+    sprintf(fileName, "%s.a3p.xml", adventureName);
+    file = fopen(fileName, "w");
+    if (file != NULL) {
+        writeXml(file);
+        fclose(file);
+    }
+
+    deallocate(fileName);
+}
@@ -0,0 +1,33 @@
+#ifndef PROFILE_H_
+#define PROFILE_H_
+/*----------------------------------------------------------------------*\
+
+  profile
+
+  Counting of executed instructions per opcode, code address and
+  source line, and the time spent on them, when running with -profile.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern void initProfile(void);
+extern void profileEnter(int depth);
+extern void profileInstruction(Aaddr address, Aword instruction);
+extern void profileLine(int file, int line);
+extern void profileExit(int depth);
+extern void writeProfile(void);
+
+#endif /* PROFILE_H_ */
@@ -882,6 +882,7 @@ bool readline(char usrbuf[])
     static bool firstInput = true;
     static uchar BOM[3] = {0xEF,0xBB,0xBF};
 
+    flushTranscript();
     if (readingCommands) {
         fflush(stdout);
         /* TODO: Arbitrarily using 255 for buffer size */
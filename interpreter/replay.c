@@ -0,0 +1,191 @@
+/*----------------------------------------------------------------------*\
+
+  replay
+
+  Restores a session from a command log ("solution"), as written with
+  -c, by taking the player commands from it instead of from the
+  player. Nothing is printed until the last command is taken, so no
+  text is formatted or written for them, but all commands are executed
+  as usual so the game ends up in the same state. The response to the
+  last command is shown, and then the player takes over.
+
+  The log only has the player commands, so other questions asked
+  while replaying, such as for a file name or a confirmation, get their
+  default answer. The player takes over early if the game asks what to
+  do after it has ended, or the debugger is entered.
+
+  The whole log is read at the start, so it may be the command log of
+  the session itself, which is then continued.
+
+\*----------------------------------------------------------------------*/
+#include "replay.h"
+
+/* IMPORTS */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "converter.h"
+#include "memory.h"
+#include "options.h"
+#include "output.h"
+#include "syserr.h"
+#include "utils.h"
+
+#ifdef HAVE_GLK
+#include "glk.h"
+#include "glkio.h"
+#endif
+
+
+/* PRIVATE DATA */
+static char *commands = NULL;   /* The whole log, NULL when not replaying */
+static char *nextCommand;
+
+
+#ifdef HAVE_GLK
+/*----------------------------------------------------------------------*/
+static char *readCommands(char *fileName) {
+    frefid_t fileRef = glk_fileref_create_by_name(fileusage_InputRecord+fileusage_TextMode, fileName, 0);
+    strid_t file;
+    char *contents = NULL;
+    glui32 allocated = 0;
+    glui32 length = 0;
+    glui32 count;
+
+    if (fileRef == NULL)
+        return NULL;
+    file = glk_stream_open_file(fileRef, filemode_Read, 0);
+    glk_fileref_destroy(fileRef);
+    if (file == NULL)
+        return NULL;
+
+    do {
+        if (length+1 >= allocated) {
+            allocated = allocated == 0? 4096 : 2*allocated;
+            contents = realloc(contents, allocated);
+            if (contents == NULL)
+                syserr("Out of memory.");
+        }
+        count = glk_get_buffer_stream(file, &contents[length], allocated-length-1);
+        length += count;
+    } while (count > 0);
+    contents[length] = '\0';
+
+    glk_stream_close(file, NULL);
+    return contents;
+}
+
+#else
+
+/*----------------------------------------------------------------------*/
+static char *readCommands(char *fileName) {
+    FILE *file = fopen(fileName, "rb");
+    char *contents;
+    long length;
+
+    if (file == NULL)
+        return NULL;
+    fseek(file, 0, SEEK_END);
+    length = ftell(file);
+    rewind(file);
+
+    contents = allocate(length+1);
+    length = fread(contents, 1, length, file);
+    contents[length] = '\0';
+
+    fclose(file);
+    return contents;
+}
+#endif
+
+
+/*======================================================================*/
+bool replaying(void) {
+    return commands != NULL;
+}
+
+
+/*======================================================================*/
+/* Stop replaying, and let the player take over */
+void endReplay(void) {
+    if (commands == NULL)
+        return;
+    deallocate(commands);
+    commands = NULL;
+    resumeOutput();
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Show the command, as the player would have seen it being typed */
+static void echoCommand(char command[]) {
+#ifdef HAVE_GLK
+    glk_set_style(style_Input);
+    printf("%s\n", command);
+    glk_set_style(style_Normal);
+#else
+    char *converted = ensureExternalEncoding(command);
+    printf("%s\n", converted);
+    free(converted);
+#endif
+}
+
+
+/*======================================================================*/
+/* Take the player commands from the command log in the file from now
+   on, with output suppressed */
+void startReplay(char *fileName) {
+    static uchar BOM[3] = {0xEF,0xBB,0xBF};
+
+    commands = readCommands(fileName);
+    if (commands == NULL) {
+        printf("Can't open command log '%s'.\n", fileName);
+        terminate(1);
+    }
+
+    nextCommand = commands;
+    if (strncmp(nextCommand, (char *)BOM, 3) == 0) {
+        encodingOption = ENCODING_UTF;
+        nextCommand += 3;
+    }
+    if (*nextCommand == '\0') {
+        deallocate(commands);
+        commands = NULL;
+    } else
+        suppressOutput();
+}
+
+
+/*======================================================================*/
+/* Get the next player command to replay, in the internal encoding, if
+   still replaying. Output is resumed when the last one is taken. */
+bool replayCommand(char buffer[], int size) {
+    char *end;
+    char *converted;
+    int length;
+
+    if (commands == NULL)
+        return false;
+
+    end = strchr(nextCommand, '\n');
+    if (end == NULL)
+        end = &nextCommand[strlen(nextCommand)];
+    length = end - nextCommand;
+    if (length > 0 && nextCommand[length-1] == '\r')
+        length--;
+    if (length > size-1)
+        length = size-1;
+    memcpy(buffer, nextCommand, length);
+    buffer[length] = '\0';
+    converted = ensureInternalEncoding(buffer);
+    strcpy(buffer, converted);
+    free(converted);
+
+    nextCommand = *end == '\n'? end+1 : end;
+    if (*nextCommand == '\0') {
+        endReplay();
+        echoCommand(buffer);
+    }
+    return true;
+}
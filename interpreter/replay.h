@@ -0,0 +1,32 @@
+#ifndef REPLAY_H_
+#define REPLAY_H_
+/*----------------------------------------------------------------------*\
+
+  replay
+
+  Restoring a session by replaying the player commands in a command
+  log, with output suppressed, before the player takes over, with
+  -replay.
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+
+
+/* FUNCTIONS */
+extern void startReplay(char *fileName);
+extern bool replaying(void);
+extern void endReplay(void);
+extern bool replayCommand(char buffer[], int size);
+
+#endif /* REPLAY_H_ */
@@ -24,27 +24,25 @@ extern Aword *memory;
 
 /*++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++*/
 static Aaddr memorySize = 0;
+
+/* A bit for every address in memory, set when the table or code at it
+   has been reversed */
 static Aword *addressesDone = NULL;
-static int numberDone = 0;
-static int doneSize = 0;
 
 static bool alreadyDone(Aaddr address)
 {
-    int i;
+    Aword bit;
 
     if (address == 0) return true;
+    if (address > memorySize) return false; /* Fails when reversed */
 
-    /* Have we already done it? */
-    for (i = 0; i < numberDone; i++)
-        if (addressesDone[i] == address)
-            return true;
+    if (addressesDone == NULL)
+        addressesDone = allocate((memorySize/32+1)*sizeof(Aword));
 
-    if (doneSize == numberDone) {
-        doneSize += 100;
-        addressesDone = realloc(addressesDone, doneSize*sizeof(Aword));
-    }
-    addressesDone[numberDone] = address;
-    numberDone++;
+    bit = (Aword)1 << (address%32);
+    if (addressesDone[address/32] & bit)
+        return true;
+    addressesDone[address/32] |= bit;
 
     return false;
 }
@@ -60,7 +58,9 @@ static bool alreadyDone(Aaddr address)
 /*----------------------------------------------------------------------*/
 Aword reversed(Aword w) /* IN - The ACODE word to swap bytes of */
 {
-#ifdef TRYNATIVE
+#if defined(__GNUC__)
+  return __builtin_bswap32(w);
+#elif defined(TRYNATIVE)
   return NATIVE(&w);
 #else
   Aword s;                      /* The swapped ACODE word */
@@ -91,36 +91,49 @@ void reverse(Aword *w)          /* IN - The ACODE word to reverse bytes in */
 }
 
 
+/* Reverse a run of words in one go, which the compiler can vectorise */
+static void reverseWords(Aword *w, int count)
+{
+    int i;
+
+    if (count == 0) return;
+    if (w < &memory[0] || &w[count-1] > &memory[memorySize])
+        syserr("Reversing address outside of memory");
+    for (i = 0; i < count; i++)
+        w[i] = reversed(w[i]);
+}
+
+
+/* Tables end with an EOF, which looks the same in both byte orders, so
+   the length can be found before reversing them */
 static void reverseTable(Aword adr, int elementSizeInBytes)
 {
   Aword *e = &memory[adr];
-  int i;
+  int words = elementSizeInBytes/sizeof(Aword);
+  int count;
 
   if (elementSizeInBytes < sizeof(Aword) || elementSizeInBytes % sizeof(Aword) != 0)
       syserr("***Wrong size in 'reverseTable()' ***");
 
   if (adr == 0) return;
 
-  while (!isEndOfArray(e)) {
-    for (i = 0; i < elementSizeInBytes/sizeof(Aword); i++) {
-      reverse(e);
-      e++;
-    }
-  }
+  for (count = 0; adr+count <= memorySize && !isEndOfArray(&e[count]); count += words)
+    ;
+  reverseWords(e, count);
 }
 
 
 static void reverseStms(Aword adr)
 {
   Aword *e = &memory[adr];
+  Aword reversedReturn = reversed((Aword)C_STMOP<<28|(Aword)I_RETURN);
+  int count;
 
   if (!adr || alreadyDone(adr)) return;
 
-  while (true) {
-    reverse(e);
-    if (*e == ((Aword)C_STMOP<<28|(Aword)I_RETURN)) break;
-    e++;
-  }
+  for (count = 0; adr+count <= memorySize && e[count] != reversedReturn; count++)
+    ;
+  reverseWords(e, count+1);
 }
 
 
@@ -672,5 +685,6 @@ void reverseACD(void)
   else
       reverseNative(version);
 
-  free(addressesDone);
+  deallocate(addressesDone);
+  addressesDone = NULL;
 }
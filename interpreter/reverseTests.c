@@ -9,23 +9,60 @@ AfterEach(Reverse){};
 
 Ensure(Reverse, canSeeIfReversalIsAlreadyDone) {
   addressesDone = NULL;
-  doneSize = 0;
-  numberDone = 0;
+  memorySize = 100;
 
   assert_that(alreadyDone(0));
-  assert_that(doneSize, is_equal_to(0));
+  assert_that(addressesDone, is_null);
 
   assert_that(alreadyDone(1), is_false);
-  assert_that(doneSize, is_equal_to(100));
-  assert_that(numberDone, is_equal_to(1));
-
   assert_that(alreadyDone(2), is_false);
-  assert_that(doneSize, is_equal_to(100));
-  assert_that(numberDone, is_equal_to(2));
+  assert_that(alreadyDone(99), is_false);
 
   assert_that(alreadyDone(1));
-  assert_that(doneSize, is_equal_to(100));
-  assert_that(numberDone, is_equal_to(2));
+  assert_that(alreadyDone(99));
+  assert_that(alreadyDone(3), is_false);
+
+  deallocate(addressesDone);
+  addressesDone = NULL;
+}
+
+Ensure(Reverse, reversesStatementsUpToAndIncludingReturn) {
+  Aword code[5];
+  Aword returnInstruction = (Aword)C_STMOP<<28|(Aword)I_RETURN;
+
+  memory = code;
+  memorySize = 4;
+  addressesDone = NULL;
+  code[0] = 0;
+  code[1] = 0x01020304;
+  code[2] = 0x05060708;
+  code[3] = reversed(returnInstruction);
+  code[4] = 0x0a0b0c0d;
+
+  reverseStms(1);
+
+  assert_that(code[1], is_equal_to(0x04030201));
+  assert_that(code[2], is_equal_to(0x08070605));
+  assert_that(code[3], is_equal_to(returnInstruction));
+  assert_that(code[4], is_equal_to(0x0a0b0c0d));
+
+  deallocate(addressesDone);
+  addressesDone = NULL;
+  memory = NULL;
+}
+
+Ensure(Reverse, reversesTableUpToEndOfArray) {
+  Aword table[6] = {0, 0x01020304, 0x05060708, 0x11121314, 0x15161718, EOF};
+
+  memory = table;
+  memorySize = 5;
+
+  reverseTable(1, 2*sizeof(Aword));
+
+  assert_that(table[1], is_equal_to(0x04030201));
+  assert_that(table[4], is_equal_to(0x18171615));
+  assert_that(isEndOfArray(&table[5]));
+  memory = NULL;
 }
 
 static void mySyserr(char *string) {
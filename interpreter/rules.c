@@ -17,6 +17,8 @@
 #include "current.h"
 #include "options.h"
 #include "compatibility.h"
+#include "instance.h"
+#include "syserr.h"
 
 #ifdef HAVE_GLK
 #include "glkio.h"
@@ -32,6 +34,10 @@ bool anyRuleRun;
 typedef struct RulesAdmin {
     bool lastEval;
     bool alreadyRun;
+    bool recorded;              /* Was last evaluated recording reads */
+    ChangeStamp evaluatedAt;
+    ReadSet reads;              /* What that evaluation read */
+    CurVars current;            /* The current variables it saw */
 } RulesAdmin;
 
 /* PRIVATE DATA: */
@@ -44,6 +50,7 @@ static void clearRulesAdmin(int ruleCount) {
     for (r = 0; r < ruleCount; r++) {
         rulesAdmin[r].lastEval = false;
         rulesAdmin[r].alreadyRun = false;
+        rulesAdmin[r].recorded = false;
     }
 }
 
@@ -200,6 +207,67 @@ void resetRules() {
 }
 
 
+/*----------------------------------------------------------------------*/
+/* Only rules that have read something that has changed since they
+   were evaluated need to be evaluated again, when not tracing or
+   debugging, which would show every evaluation */
+static bool mustEvaluateAllRules(void) {
+    return evaluateAllRulesOption || debugOption || traceSectionOption || detailedTraceOn();
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool sameCurrentValues(CurVars *seen) {
+    return seen->location == current.location && seen->actor == current.actor
+        && seen->verb == current.verb && seen->instance == current.instance
+        && seen->score == current.score;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool readsHaveChanged(RulesAdmin *admin) {
+    if (!admin->recorded || admin->reads.untracked)
+        return true;
+    if (admin->reads.current && !sameCurrentValues(&admin->current))
+        return true;
+    if (admin->reads.locations && locationsChangedSince(admin->evaluatedAt))
+        return true;
+    return attributesChangedSince(admin->reads.attributes, admin->evaluatedAt);
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool evaluateRecordingReads(RuleEntry rules[], int rule) {
+    RulesAdmin *admin = &rulesAdmin[rule-1];
+    bool value;
+
+    memset(&admin->reads, 0, sizeof(admin->reads));
+    admin->current = current;
+    admin->evaluatedAt = currentChangeStamp();
+    readSet = &admin->reads;
+    value = evaluate(rules[rule-1].exp);
+    readSet = NULL;
+    admin->recorded = true;
+    return value;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool evaluateRule(RuleEntry rules[], int rule) {
+    RulesAdmin *admin = &rulesAdmin[rule-1];
+
+    if (mustEvaluateAllRules()) {
+        admin->recorded = false;
+        return evaluate(rules[rule-1].exp);
+    }
+    if (readsHaveChanged(admin))
+        return evaluateRecordingReads(rules, rule);
+    if (checkRulesOption && evaluate(rules[rule-1].exp) != admin->lastEval)
+        syserr("Rule evaluated differently although nothing it read had changed.");
+    return admin->lastEval;
+}
+
+
 /*======================================================================*/
 void evaluateRules(RuleEntry rules[]) {
     bool change = true;
@@ -207,12 +275,13 @@ void evaluateRules(RuleEntry rules[]) {
 
     current.location = NOWHERE;
     current.actor = 0;
+    readSet = NULL;
 
     while (change) {
         change = false;
         for (rule = 1; !isEndOfArray(&rules[rule-1]); rule++) {
             traceRuleEvaluation(rule);
-            bool evaluated_value = evaluate(rules[rule-1].exp);
+            bool evaluated_value = evaluateRule(rules, rule);
             traceRuleResult(rule, evaluated_value);
             if (evaluated_value == true && rulesAdmin[rule-1].lastEval == false
                 && !rulesAdmin[rule-1].alreadyRun) {
@@ -4,6 +4,7 @@
 #include "rules.h"
 
 #include "lists.h"
+#include "options.h"
 
 /* Mocked modules */
 #include "inter.mock"
@@ -43,9 +44,13 @@ Describe(Rules);
 
 BeforeEach(Rules) {
     memory = allocate_memory();
+    always_expect(currentChangeStamp);
+    always_expect(locationsChangedSince);
+    always_expect(attributesChangedSince);
 }
 
 AfterEach(Rules) {
+    evaluateAllRulesOption = false;
     free(memory);
 }
 
@@ -67,3 +72,27 @@ Ensure(Rules, dont_run_if_one_rule_evaluate_to_false) {
     initRules(address_to_rules);
     evaluateRules(rules);
 }
+
+Ensure(Rules, dont_evaluate_rule_again_if_nothing_it_read_changed) {
+    never_expect(interpret);
+    expect(evaluate, when(adr, is_equal_to(1)), will_return(false));
+
+    rules = setup_rules(1);
+
+    initRules(address_to_rules);
+    evaluateRules(rules);
+    evaluateRules(rules);
+}
+
+Ensure(Rules, evaluate_rule_every_time_if_evaluating_all_rules) {
+    never_expect(interpret);
+    expect(evaluate, when(adr, is_equal_to(1)), will_return(false));
+    expect(evaluate, when(adr, is_equal_to(1)), will_return(false));
+
+    evaluateAllRulesOption = true;
+    rules = setup_rules(1);
+
+    initRules(address_to_rules);
+    evaluateRules(rules);
+    evaluateRules(rules);
+}
@@ -20,6 +20,8 @@
 #include "score.h"
 #include "event.h"
 #include "msg.h"
+#include "containment.h"
+#include "replay.h"
 
 #ifndef HAVE_GLK
 static char saveFileName[256];
@@ -73,7 +75,12 @@ static void saveGameInfo(AFILE saveFile) {
 
 /*----------------------------------------------------------------------*/
 static void saveAdmin(AFILE saveFile) {
-    fwrite((void *)&admin[1], sizeof(AdminEntry), header->instanceMax, saveFile);
+    AdminEntry entry;
+
+    for (int i = 1; i <= header->instanceMax; i++) {
+        getAdminEntry(i, &entry);
+        fwrite((void *)&entry, sizeof(AdminEntry), 1, saveFile);
+    }
 }
 
 
@@ -85,6 +92,7 @@ static void saveAttributeArea(AFILE saveFile) {
 
 /*----------------------------------------------------------------------*/
 static void saveEventQueue(AFILE saveFile) {
+    exportEventQueue();
     fwrite((void *)&eventQueueTop, sizeof(eventQueueTop), 1, saveFile);
     fwrite((void *)&eventQueue[0], sizeof(eventQueue[0]), eventQueueTop, saveFile);
 }
@@ -128,6 +136,8 @@ void save(void)
 #ifdef HAVE_GLK
     frefid_t saveFileRef;
     strid_t saveFile;
+    /* There is no default file to take when replaying */
+    if (replaying()) return;
     saveFileRef = glk_fileref_create_by_prompt(fileusage_SavedGame, filemode_Write, 0);
     if (saveFileRef == NULL)
         error(M_SAVEFAILED);
@@ -147,7 +157,11 @@ void save(void)
     sprintf(str, "(%s) : ", saveFileName);
     output(str);
 #ifdef USE_READLINE
-    readline(str);
+    /* The command log has no file names, so take the default */
+    if (replaying())
+        str[0] = '\0';
+    else
+        readline(str);
 #else
     gets(str);
 #endif
@@ -232,22 +246,25 @@ static void restoreEventQueue(AFILE saveFile) {
     if (eventQueueTop > eventQueueSize) {
         deallocate(eventQueue);
         eventQueue = allocate(eventQueueTop*sizeof(eventQueue[0]));
+        eventQueueSize = eventQueueTop;
     }
     rc = fread((void *)&eventQueue[0], sizeof(eventQueue[0]), eventQueueTop, saveFile);
+    importEventQueue();
 }
 
 
 /*----------------------------------------------------------------------*/
 static void restoreAdmin(AFILE saveFile) {
-    /* Restore admin for instances, remember to reset attribute area pointer */
+    /* Restore admin for instances, the attribute area pointer is kept */
+    AdminEntry entry;
     int rc;
     (void)rc;                   /* UNUSED */
 
     for (int i = 1; i <= header->instanceMax; i++) {
-        AttributeEntry *currentAttributesArea = admin[i].attributes;
-        rc = fread((void *)&admin[i], sizeof(AdminEntry), 1, saveFile);
-        admin[i].attributes = currentAttributesArea;
+        rc = fread((void *)&entry, sizeof(AdminEntry), 1, saveFile);
+        setAdminEntry(i, &entry);
     }
+    indexContainment();
 }
 
 
@@ -257,6 +274,7 @@ static void restoreAttributeArea(AFILE saveFile) {
     (void)rc;                   /* UNUSED */
 
     rc = fread((void *)attributes, header->attributesAreaSize, sizeof(Aword), saveFile);
+    allAttributesChanged();
 }
 
 
@@ -349,6 +367,8 @@ void restore(void)
 #ifdef HAVE_GLK
     frefid_t saveFileRef;
     strid_t saveFile;
+    /* There is no default file to take when replaying */
+    if (replaying()) return;
     saveFileRef = glk_fileref_create_by_prompt(fileusage_SavedGame, filemode_Read, 0);
     if (saveFileRef == NULL) return;
     saveFile = glk_stream_open_file(saveFileRef, filemode_Read, 0);
@@ -368,7 +388,11 @@ void restore(void)
     sprintf(str, "(%s) : ", saveFileName);
     output(str);
 #ifdef USE_READLINE
-    readline(str);
+    /* The command log has no file names, so take the default */
+    if (replaying())
+        str[0] = '\0';
+    else
+        readline(str);
 #else
     gets(str);
 #endif
@@ -12,7 +12,9 @@
 #include "output.mock"
 #include "current.mock"
 #include "syserr.mock"
+#include "containment.mock"
 #include "readline.mock"
+#include "replay.mock"
 #include "msg.mock"
 
 
@@ -27,7 +29,14 @@ extern void restoreScores(AFILE saveFile);
 
 
 Describe(Save);
-BeforeEach(Save) {}
+BeforeEach(Save) {
+  always_expect(indexContainment);
+  always_expect(allAttributesChanged);
+  always_expect(getAdminEntry);
+  always_expect(setAdminEntry);
+  always_expect(exportEventQueue);
+  always_expect(importEventQueue);
+}
 AfterEach(Save) {}
 
 
@@ -66,16 +75,16 @@ Ensure(Save, canSaveRestore) {
   attributes[20].code = EOF;
 
   /* Fake admin areas for 3 instances */
-  admin = allocate(5*sizeof(AdminEntry));
-  admin[1].attributes = &attributes[0];
-  admin[1].attributes[0].code = 11;
-  admin[1].attributes[0].value = 11;
-  admin[2].attributes = &attributes[5];
-  admin[2].attributes[0].code = 22;
-  admin[2].attributes[0].value = 22;
-  admin[3].attributes = &attributes[7];
-  admin[3].attributes[0].code = 33;
-  admin[3].attributes[0].value = 33;
+  admin.attributes = allocate(5*sizeof(AttributeEntry *));
+  admin.attributes[1] = &attributes[0];
+  admin.attributes[1][0].code = 11;
+  admin.attributes[1][0].value = 11;
+  admin.attributes[2] = &attributes[5];
+  admin.attributes[2][0].code = 22;
+  admin.attributes[2][0].value = 22;
+  admin.attributes[3] = &attributes[7];
+  admin.attributes[3][0].code = 33;
+  admin.attributes[3][0].value = 33;
 
   /* Save the game data */
   saveGame(saveFile);
@@ -88,21 +97,21 @@ Ensure(Save, canSaveRestore) {
     attributes[20-i].code = i;
     attributes[20-i].value = i;
   }
-  admin[1].attributes = &attributes[0];
-  admin[2].attributes = &attributes[5];
-  admin[3].attributes = &attributes[7];
+  admin.attributes[1] = &attributes[0];
+  admin.attributes[2] = &attributes[5];
+  admin.attributes[3] = &attributes[7];
 
   saveFile = fopen("testSaveFile", "r");
   restoreGame(saveFile);
   fclose(saveFile);
   unlink("testSaveFile");
 
-  assert_equal(11, admin[1].attributes[0].code);
-  assert_equal(11, admin[1].attributes[0].value);
-  assert_equal(22, admin[2].attributes[0].code);
-  assert_equal(22, admin[2].attributes[0].value);
-  assert_equal(33, admin[3].attributes[0].code);
-  assert_equal(33, admin[3].attributes[0].value);
+  assert_equal(11, admin.attributes[1][0].code);
+  assert_equal(11, admin.attributes[1][0].value);
+  assert_equal(22, admin.attributes[2][0].code);
+  assert_equal(22, admin.attributes[2][0].value);
+  assert_equal(33, admin.attributes[3][0].code);
+  assert_equal(33, admin.attributes[3][0].value);
 }
 
 Ensure(Save, canSaveStrings) {
@@ -135,8 +144,8 @@ Ensure(Save, canSaveStrings) {
   attributes[1].code = EOF;
 
   /* Fake admin areas for one instance */
-  admin = allocate(2*sizeof(AdminEntry));
-  admin[1].attributes = &attributes[0];
+  admin.attributes = allocate(2*sizeof(AttributeEntry *));
+  admin.attributes[1] = &attributes[0];
 
   /* A String Init Table is required */
   memory = allocate(3*sizeof(StringInitEntry));
@@ -157,14 +166,14 @@ Ensure(Save, canSaveStrings) {
   /* Save the game data */
   saveGame(saveFile);
   fclose(saveFile);
-  admin[1].attributes[0].value = toAptr(strdup("i lingonskogen"));
+  admin.attributes[1][0].value = toAptr(strdup("i lingonskogen"));
 
   saveFile = fopen(testFileName, "r");
   restoreGame(saveFile);
   fclose(saveFile);
   unlink(testFileName);
 
-  assert_equal(0, strcmp((char *)fromAptr(admin[1].attributes[0].value), testString));
+  assert_equal(0, strcmp((char *)fromAptr(admin.attributes[1][0].value), testString));
 }
 
 Ensure(Save, canSaveSets) {
@@ -209,8 +218,8 @@ Ensure(Save, canSaveSets) {
   attributes[4].code = EOF;
 
   /* Fake admin areas for one instances */
-  admin = allocate(2*sizeof(AdminEntry));
-  admin[1].attributes = &attributes[0];
+  admin.attributes = allocate(2*sizeof(AttributeEntry *));
+  admin.attributes[1] = &attributes[0];
 
   /* A Set Init Table is required */
   memory = allocate(5*sizeof(SetInitEntry));
@@ -245,7 +254,7 @@ Ensure(Save, canSaveSets) {
 
   /* Set new values */
   for (i = 0; i < 4; i++)
-      admin[1].attributes[i].value = toAptr(newSet(0));
+      admin.attributes[1][i].value = toAptr(newSet(0));
 
   saveFile = fopen(testFileName, "r");
   restoreGame(saveFile);
@@ -254,7 +263,7 @@ Ensure(Save, canSaveSets) {
 
   /* Don't need these because of the expect() */
   for (i = 0; i < 4; i++)
-      assert_true(equalSets((Set *)fromAptr(admin[1].attributes[i].value), testSet[i]));
+      assert_true(equalSets((Set *)fromAptr(admin.attributes[1][i].value), testSet[i]));
 }
 
 Ensure(Save, canSaveRestoreScore) {
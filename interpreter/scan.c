@@ -24,6 +24,7 @@
 #include "msg.h"
 #include "inter.h"
 #include "converter.h"
+#include "replay.h"
 
 
 #ifdef USE_READLINE
@@ -53,7 +54,7 @@ void forceNewPlayerInput() {
 
 /*----------------------------------------------------------------------*/
 static void unknown(char token[]) {
-    Parameter *messageParameters = newParameterArray();
+    Parameter *messageParameters = newTemporaryParameterArray();
 
     addParameterForString(messageParameters, token);
     printMessageWithParameters(M_UNKNOWN_WORD, messageParameters);
@@ -73,15 +74,7 @@ static int number(char token[]) {
 
 /*----------------------------------------------------------------------*/
 static int lookup(char wrd[]) {
-    int i;
-
-    // TODO: Why do we start at 0, is there a word code == 0?
-    for (i = 0; !isEndOfArray(&dictionary[i]); i++) {
-        if (equalStrings(wrd, (char *) pointerTo(dictionary[i].string))) {
-            return i;
-        }
-    }
-    return EOF;
+    return findWord(wrd);
 }
 
 
@@ -161,7 +154,7 @@ static void getLine(void) {
         printPrompt();
 
 #ifdef USE_READLINE
-        if (!readline(input_buffer))
+        if (!replayCommand(input_buffer, sizeof(input_buffer)) && !readline(input_buffer))
 #else
         fflush(stdout);
         if (fgets(buf, LISTLEN, stdin) == NULL)
@@ -185,7 +178,7 @@ static void getLine(void) {
                 fflush(commandLogFile);
 #endif
             }
-            if (transcriptOption) {
+            if (transcriptOption && !outputSuppressed) {
 #ifdef HAVE_GLK
                 glk_put_string_stream(transcriptFile, converted);
                 glk_put_char_stream(transcriptFile, '\n');
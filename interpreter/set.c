@@ -9,16 +9,138 @@
     value. As members are only references, clearing a set can
     simply be done by setting the size to zero.
 
+    The members are kept in the order they were added, which is
+    the order they are indexed, iterated and saved in. When a set
+    grows beyond a few members it also gets an index to find
+    members quickly: a bit for each possible instance number, and
+    a sorted array of any other values.
+
 \*----------------------------------------------------------------------*/
 #include "set.h"
 
 /* Imports: */
+#include <stdlib.h>
+#include <string.h>
+
 #include "lists.h"
 #include "syserr.h"
 #include "memory.h"
 #include "instance.h"
+#include "bitset.h"
 
 #define EXTENT 5
+#define SMALL_SET 8             /* Larger sets are indexed */
+#define BITS_PER_WORD (8*sizeof(BitsetWord))
+
+
+struct SetIndex {
+  Aword denseSize;              /* Members below this are bits */
+  BitsetWord *bits;
+  int sparseSize;
+  int sparseAllocated;
+  Aword *sparse;                /* The other members, sorted */
+};
+
+
+/*----------------------------------------------------------------------*/
+static int sparsePosition(SetIndex *index, Aword member) {
+  int low = 0, high = index->sparseSize;
+
+  while (low < high) {
+    int middle = (low+high)/2;
+    if (index->sparse[middle] < member)
+      low = middle+1;
+    else
+      high = middle;
+  }
+  return low;
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool inIndex(SetIndex *index, Aword member) {
+  int position;
+
+  if (member < index->denseSize)
+    return (index->bits[member/BITS_PER_WORD] >> (member%BITS_PER_WORD)) & 1;
+  position = sparsePosition(index, member);
+  return position < index->sparseSize && index->sparse[position] == member;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void addToIndex(SetIndex *index, Aword member) {
+  int position;
+
+  if (member < index->denseSize) {
+    index->bits[member/BITS_PER_WORD] |= (BitsetWord)1 << (member%BITS_PER_WORD);
+    return;
+  }
+  if (index->sparseSize == index->sparseAllocated) {
+    index->sparseAllocated = index->sparseAllocated == 0? EXTENT : 2*index->sparseAllocated;
+    index->sparse = realloc(index->sparse, index->sparseAllocated*sizeof(index->sparse[0]));
+    if (index->sparse == NULL)
+      syserr("Out of memory.");
+  }
+  position = sparsePosition(index, member);
+  memmove(&index->sparse[position+1], &index->sparse[position],
+          (index->sparseSize-position)*sizeof(index->sparse[0]));
+  index->sparse[position] = member;
+  index->sparseSize++;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void removeFromIndex(SetIndex *index, Aword member) {
+  int position;
+
+  if (member < index->denseSize) {
+    index->bits[member/BITS_PER_WORD] &= ~((BitsetWord)1 << (member%BITS_PER_WORD));
+    return;
+  }
+  position = sparsePosition(index, member);
+  memmove(&index->sparse[position], &index->sparse[position+1],
+          (index->sparseSize-position-1)*sizeof(index->sparse[0]));
+  index->sparseSize--;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void freeIndex(SetIndex *index) {
+  if (index != NULL) {
+    if (index->sparse != NULL)
+      deallocate(index->sparse);
+    deallocate(index);
+  }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void indexSet(Set *theSet) {
+  Aword denseSize = header->instanceMax+1;
+  int words = (denseSize+BITS_PER_WORD-1)/BITS_PER_WORD;
+  SetIndex *index = allocate(sizeof(SetIndex) + words*sizeof(BitsetWord));
+  int i;
+
+  index->denseSize = denseSize;
+  index->bits = (BitsetWord *)(index+1);
+  for (i = 0; i < theSet->size; i++)
+    addToIndex(index, theSet->members[i]);
+  theSet->index = index;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void ensureAllocated(Set *theSet, int size) {
+  if (size > theSet->allocated) {
+    theSet->allocated = theSet->allocated < EXTENT? EXTENT : 2*theSet->allocated;
+    if (theSet->allocated < size)
+      theSet->allocated = size;
+    theSet->members = realloc(theSet->members, theSet->allocated*sizeof(theSet->members[0]));
+    if (theSet->members == NULL)
+      syserr("Out of memory.");
+  }
+}
 
 
 /*======================================================================*/
@@ -59,16 +181,20 @@ int setSize(Set *theSet) {
 /*======================================================================*/
 void clearSet(Set *theSet) {
   theSet->size = 0;
+  freeIndex(theSet->index);
+  theSet->index = NULL;
 }
 
 
 /*======================================================================*/
 Set *copySet(Set *theSet) {
   Set *new = newSet(theSet->size);
-  int i;
 
-  for (i = 1; i <= theSet->size; i++)
-    addToSet(new, getSetMember(theSet, i));
+  if (theSet->size > 0)
+    memcpy(new->members, theSet->members, theSet->size*sizeof(theSet->members[0]));
+  new->size = theSet->size;
+  if (new->size > SMALL_SET)
+    indexSet(new);
   return new;
 }
 
@@ -86,8 +212,10 @@ bool inSet(Set *theSet, Aword member)
 {
   int i;
 
-  for (i = 1; i <= theSet->size; i++)
-    if (getSetMember(theSet, i) == member)
+  if (theSet->index != NULL)
+    return inIndex(theSet->index, member);
+  for (i = 0; i < theSet->size; i++)
+    if (theSet->members[i] == member)
       return true;
   return false;
 }
@@ -96,11 +224,9 @@ bool inSet(Set *theSet, Aword member)
 /*=======================================================================*/
 Set *setUnion(Set *set1, Set *set2)
 {
-  Set *theUnion = newSet(set1->size+set2->size);
+  Set *theUnion = copySet(set1);
   int i;
 
-  for (i = 0; i < set1->size; i++)
-    addToSet(theUnion, set1->members[i]);
   for (i = 0; i < set2->size; i++)
     addToSet(theUnion, set2->members[i]);
   return theUnion;
@@ -111,30 +237,34 @@ Set *setUnion(Set *set1, Set *set2)
 void addToSet(Set *theSet, Aword newMember)
 {
   if (inSet(theSet, newMember)) return;
-  if (theSet->size == theSet->allocated) {
-    theSet->allocated += EXTENT;
-    theSet->members = realloc(theSet->members, theSet->allocated*sizeof(theSet->members[0]));
-  }
+  ensureAllocated(theSet, theSet->size+1);
   theSet->members[theSet->size] = newMember;
   theSet->size++;
+  if (theSet->index != NULL)
+    addToIndex(theSet->index, newMember);
+  else if (theSet->size > SMALL_SET)
+    indexSet(theSet);
 }
 
 
 /*=======================================================================*/
 void removeFromSet(Set *theSet, Aword member)
 {
-  int i, j;
+  int i;
 
   if (!inSet(theSet, member)) return;
 
+  /* Close the gap to keep the order of the remaining members */
   for (i = 0; i < theSet->size; i++) {
     if ((Aword)theSet->members[i] == member) {
-      for (j = i; j < theSet->size-1; j++)
-    theSet->members[j] = theSet->members[j+1];
+      memmove(&theSet->members[i], &theSet->members[i+1],
+              (theSet->size-i-1)*sizeof(theSet->members[0]));
       theSet->size--;
       break;
     }
   }
+  if (theSet->index != NULL)
+    removeFromIndex(theSet->index, member);
 }
 
 
@@ -158,6 +288,7 @@ void freeSet(Set *theSet) {
     if (theSet != NULL) {
         if (theSet->members != NULL)
             deallocate(theSet->members);
+        freeIndex(theSet->index);
         deallocate(theSet);
     }
 }
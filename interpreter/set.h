@@ -8,7 +8,7 @@
   
   A Set is implemented as a small datastucture holding a current size,
   allocated size and a pointer to the member array which is dynamically
-  allocated.
+  allocated. Larger sets also have an index for finding members.
 
 \*----------------------------------------------------------------------*/
 
@@ -16,10 +16,13 @@
 #include "types.h"
 
 
+typedef struct SetIndex SetIndex;
+
 typedef struct Set {
   int size;
   int allocated;
-  Aword *members;
+  Aword *members;               /* In the order they were added */
+  SetIndex *index;              /* NULL while the set is small */
 } Set;
 
 
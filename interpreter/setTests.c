@@ -124,3 +124,77 @@ Ensure(Set, testCompareSets) {
   assert_true(!equalSets(set1, set3));
   assert_true(equalSets(set3, set4));
 }
+
+
+Ensure(Set, keepsTheOrderOfMembersWhenIndexed) {
+  Set *aSet = newSet(0);
+  int i;
+
+  header->instanceMax = 20;
+  for (i = 30; i > 0; i--)
+    addToSet(aSet, i*3);
+  assert_true(aSet->index != NULL);
+  for (i = 1; i <= 30; i++)
+    assert_true(getSetMember(aSet, i) == (31-i)*3);
+
+  removeFromSet(aSet, 45);
+  removeFromSet(aSet, 6);
+  assert_true(setSize(aSet) == 28);
+  assert_true(getSetMember(aSet, 1) == 90);
+  assert_true(getSetMember(aSet, 16) == 42);
+  assert_true(getSetMember(aSet, 28) == 3);
+  header->instanceMax = 0;
+}
+
+
+Ensure(Set, findsMembersInTheIndex) {
+  Set *aSet = newSet(0);
+  int i;
+
+  header->instanceMax = 100;
+  for (i = 1; i <= 20; i++) {
+    addToSet(aSet, i*10);       /* Both instances and other values */
+    addToSet(aSet, i*10);
+  }
+  assert_true(setSize(aSet) == 20);
+  for (i = 0; i <= 210; i++)
+    assert_true(inSet(aSet, i) == (i%10 == 0 && i > 0 && i <= 200));
+
+  removeFromSet(aSet, 50);
+  removeFromSet(aSet, 150);
+  assert_true(!inSet(aSet, 50));
+  assert_true(!inSet(aSet, 150));
+  assert_true(inSet(aSet, 60));
+  assert_true(inSet(aSet, 160));
+  header->instanceMax = 0;
+}
+
+
+Ensure(Set, comparesAndCopiesIndexedSets) {
+  Set *set1 = newSet(0);
+  Set *set2 = newSet(0);
+  Set *copy;
+  int i;
+
+  header->instanceMax = 10;
+  for (i = 1; i <= 20; i++) {
+    addToSet(set1, i);
+    addToSet(set2, 21-i);
+  }
+  assert_true(equalSets(set1, set2));
+  copy = copySet(set1);
+  assert_true(equalSets(copy, set2));
+  assert_true(getSetMember(copy, 20) == 20);
+
+  removeFromSet(set2, 15);
+  addToSet(set2, 25);
+  assert_true(!equalSets(set1, set2));
+
+  clearSet(copy);
+  assert_true(!inSet(copy, 5));
+  assert_true(!inSet(copy, 15));
+  freeSet(copy);
+  freeSet(set1);
+  freeSet(set2);
+  header->instanceMax = 0;
+}
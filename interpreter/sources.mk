@@ -8,18 +8,27 @@ include ../mk/include_guard.mk
 # Either using its runner which discovers test automatically...
 # With everything mocked so they run in complete isolation...
 MODULES_WITH_ISOLATED_UNITTESTS = \
+	attribute \
+	bitset \
+	branches \
 	compatibility \
+	containment \
+	decode \
 	dictionary \
+	event \
 	exe \
+	image \
 	instance \
 	lists \
 	literal \
 	memory \
+	predecode \
 	readline \
 	rules \
 	save \
 	stack \
 	sysdep \
+	textcache \
 
 # ... or in one library linked with all modules (much less clean...)
 # These have corresponding xxxTests.c which #include xxx.c to get at
@@ -54,19 +63,27 @@ MODULES_WITHOUT_UNITTESTS = \
 	act.c \
 	actor.c \
 	attribute.c \
+	batch.c \
+	bitset.c \
+	branches.c \
 	checkentry.c \
 	class.c \
 	current.c \
 	compatibility.c \
+	containment.c \
 	decode.c \
 	dictionary.c \
 	event.c \
+	image.c \
 	lists.c \
 	literal.c \
 	memory.c \
 	msg.c \
 	options.c \
+	predecode.c \
+	profile.c \
 	readline.c \
+	replay.c \
 	rules.c \
 	save.c \
 	scan.c \
@@ -74,6 +91,7 @@ MODULES_WITHOUT_UNITTESTS = \
 	syntax.c \
 	syserr.c \
 	term.c \
+	textcache.c \
 	types.c \
 	fnmatch.c \
 	converter.c
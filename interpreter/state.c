@@ -19,36 +19,76 @@
 #include "score.h"
 #include "event.h"
 #include "set.h"
+#include "containment.h"
+#include "options.h"
 
 
 /* PUBLIC DATA */
 
 
+/* CONSTANTS */
+#define UNDO_MEMORY_BUDGET (16*1024*1024) /* Max bytes in the undo journal */
+#define PAGE_SIZE 32                      /* Words compared at a time */
+
+
 /* PRIVATE TYPES */
 
-/* Implementation of the abstract type typedef struct game_state GameState */
+/* The fields of the administrative data that are remembered. The
+   checkpoint keeps them like 'admin' does, as one array for each field
+   indexed by instance, but all in one block. */
+typedef enum AdminField {
+    LOCATION_FIELD,
+    ALREADY_DESCRIBED_FIELD,
+    VISITS_COUNT_FIELD,
+    SCRIPT_FIELD,
+    STEP_FIELD,
+    WAIT_COUNT_FIELD,
+    ADMIN_FIELDS
+} AdminField;
+
+/* A word in the instance data (the administrative data followed by
+   the attribute area) and the value it had in an earlier state */
+typedef struct WordChange {
+    int offset;
+    Aword value;
+} WordChange;
+
+/* Implementation of the abstract type typedef struct game_state GameState
+
+   The most recently remembered state (the checkpoint) is kept as a
+   complete copy. The states on the stack only record what was
+   different in the state remembered before them (the undo journal),
+   so recalling a state restores the checkpoint and then rolls the
+   checkpoint back one step using the journal entry of that state. */
 struct game_state {
     /* Event queue */
     EventQueueEntry *eventQueue;
     int eventQueueTop;			/* Event queue top pointer */
+    bool eventsChanged;         /* Journal only: eventQueue is valid */
 
     /* Scores */
     int score;
-    Aword *scores;				/* Score table pointer */
+    Aword *scores;				/* Score table pointer, journal: NULL if unchanged */
 
     /* Instance data */
-    AdminEntry *admin;			/* Administrative data about instances */
+    Aword *admin;				/* Administrative data about instances, by field */
     AttributeEntry *attributes;	/* Attributes data area */
     /* Sets and strings are dynamically allocated areas for which the
        attribute is just a pointer to. So they are not catched by the
        saving of attributes, instead they require special storage */
-    Set **sets;					/* Array of set pointers */
-    char **strings;				/* Array of string pointers */
+    Set **sets;					/* Array of set pointers, journal: NULL if unchanged */
+    char **strings;				/* Array of string pointers, journal: NULL if unchanged */
+
+    /* Journal only: words in admin and attributes that changed */
+    WordChange *changes;
+    int changeCount;
+    long size;                  /* Bytes used by the journal entry */
 };
 
 /* PRIVATE DATA */
-static GameState gameState;     /* TODO: Make pointer, then we don't have to copy to stack, we can just use the pointer */
+static GameState gameState;     /* The checkpoint */
 static StateStackP stateStack = NULL;
+static long journalSize = 0;    /* Bytes used by the journal entries on the stack */
 
 static char *playerCommand;
 
@@ -70,8 +110,10 @@ static void deallocateStrings(GameState *gameState) {
     int count = countStrings();
     int i;
 
+    if (gameState->strings == NULL) return;
     for (i = 0; i < count; i++)
-        deallocate(gameState->strings[i]);
+        if (gameState->strings[i] != NULL)
+            deallocate(gameState->strings[i]);
     deallocate(gameState->strings);
 }
 
@@ -92,6 +134,7 @@ static void deallocateSets(GameState *gameState) {
     int count = countSets();
     int i;
 
+    if (gameState->sets == NULL) return;
     for (i = 0; i < count; i++)
         freeSet(gameState->sets[i]);
     deallocate(gameState->sets);
@@ -100,10 +143,12 @@ static void deallocateSets(GameState *gameState) {
 /*======================================================================*/
 void deallocateGameState(GameState *gameState) {
 
-    deallocate(gameState->admin);
-    deallocate(gameState->attributes);
+    if (gameState->admin)
+        deallocate(gameState->admin);
+    if (gameState->attributes)
+        deallocate(gameState->attributes);
 
-    if (gameState->eventQueueTop > 0) {
+    if (gameState->eventQueue) {
         deallocate(gameState->eventQueue);
         gameState->eventQueue = NULL;
     }
@@ -113,15 +158,114 @@ void deallocateGameState(GameState *gameState) {
     deallocateStrings(gameState);
     deallocateSets(gameState);
 
+    if (gameState->changes)
+        deallocate(gameState->changes);
+
     memset(gameState, 0, sizeof(GameState));
 }
 
 
+/*----------------------------------------------------------------------*/
+static int adminWords(void) {
+    return ADMIN_FIELDS*(header->instanceMax+1);
+}
+
+
+/*----------------------------------------------------------------------*/
+static Aword *adminField(AdminField field) {
+    switch (field) {
+    case LOCATION_FIELD: return (Aword *)admin.location;
+    case ALREADY_DESCRIBED_FIELD: return (Aword *)admin.alreadyDescribed;
+    case VISITS_COUNT_FIELD: return (Aword *)admin.visitsCount;
+    case SCRIPT_FIELD: return (Aword *)admin.script;
+    case STEP_FIELD: return (Aword *)admin.step;
+    case WAIT_COUNT_FIELD: return (Aword *)admin.waitCount;
+    default: syserr("Unexpected field in adminField()");
+    }
+    return NULL;
+}
+
+
+/*----------------------------------------------------------------------*/
+static Aword *checkpointAdminField(AdminField field) {
+    return &gameState.admin[field*(header->instanceMax+1)];
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Roll the checkpoint back to the state before it using the journal
+   entry, which is consumed */
+static void rollBackCheckpoint(GameState *journal) {
+    Aword *checkpointAdmin = (Aword *)gameState.admin;
+    Aword *checkpointAttributes = (Aword *)gameState.attributes;
+    int setCount = countSets();
+    int stringCount = countStrings();
+    int i;
+
+    for (i = 0; i < journal->changeCount; i++) {
+        int offset = journal->changes[i].offset;
+        if (offset < adminWords())
+            checkpointAdmin[offset] = journal->changes[i].value;
+        else {
+            checkpointAttributes[offset-adminWords()] = journal->changes[i].value;
+            /* Now differs from the attribute, so needs to be compared */
+            attributeWordWritten(offset-adminWords());
+        }
+    }
+
+    if (journal->eventsChanged) {
+        if (gameState.eventQueue)
+            deallocate(gameState.eventQueue);
+        gameState.eventQueue = journal->eventQueue;
+        gameState.eventQueueTop = journal->eventQueueTop;
+        journal->eventQueue = NULL;
+    }
+
+    gameState.score = journal->score;
+    if (journal->scores != NULL) {
+        deallocate(gameState.scores);
+        gameState.scores = journal->scores;
+        journal->scores = NULL;
+    }
+
+    if (journal->sets != NULL)
+        for (i = 0; i < setCount; i++)
+            if (journal->sets[i] != NULL) {
+                freeSet(gameState.sets[i]);
+                gameState.sets[i] = journal->sets[i];
+                journal->sets[i] = NULL;
+            }
+    if (journal->strings != NULL)
+        for (i = 0; i < stringCount; i++)
+            if (journal->strings[i] != NULL) {
+                deallocate(gameState.strings[i]);
+                gameState.strings[i] = journal->strings[i];
+                journal->strings[i] = NULL;
+            }
+
+    deallocateGameState(journal);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void popJournalEntry(char **playerCommand) {
+    GameState journal;
+
+    popGameState(stateStack, &journal, playerCommand);
+    journalSize -= journal.size;
+    if (stateStackIsEmpty(stateStack)) {
+        /* Nothing more to roll back to */
+        deallocateGameState(&journal);
+        deallocateGameState(&gameState);
+    } else
+        rollBackCheckpoint(&journal);
+}
+
+
 /*======================================================================*/
 void forgetGameState(void) {
     char *playerCommand;
-    popGameState(stateStack, &gameState, &playerCommand);
-    deallocateGameState(&gameState);
+    popJournalEntry(&playerCommand);
     if (playerCommand != NULL)
         deallocate(playerCommand);
 }
@@ -132,6 +276,8 @@ void initStateStack(void) {
     if (stateStack != NULL)
         deleteStateStack(stateStack);
     stateStack = createStateStack(sizeof(GameState));
+    deallocateGameState(&gameState);
+    journalSize = 0;
 }
 
 
@@ -139,6 +285,8 @@ void initStateStack(void) {
 void terminateStateStack(void) {
     deleteStateStack(stateStack);
     stateStack = NULL;
+    deallocateGameState(&gameState);
+    journalSize = 0;
 }
 
 
@@ -199,13 +347,20 @@ static void collectEvents(void) {
     gameState.eventQueueTop = eventQueueTop;
     if (eventQueueTop > 0)
         gameState.eventQueue = duplicate(eventQueue, eventQueueTop*sizeof(EventQueueEntry));
+    else
+        gameState.eventQueue = NULL;
 }
 
 
 /*----------------------------------------------------------------------*/
 static void collectInstanceData(void) {
-    gameState.admin = duplicate(admin, (header->instanceMax+1)*sizeof(AdminEntry));
+    AdminField field;
+
+    gameState.admin = allocate(adminWords()*sizeof(Aword));
+    for (field = 0; field < ADMIN_FIELDS; field++)
+        memcpy(checkpointAdminField(field), adminField(field), (header->instanceMax+1)*sizeof(Aword));
     gameState.attributes = duplicate(attributes, header->attributesAreaSize*sizeof(Aword));
+    forgetWrittenAttributes();
     gameState.sets = collectSets();
     gameState.strings = collectStrings();
 }
@@ -221,16 +376,203 @@ static void collectScores(void) {
 }
 
 
+/*----------------------------------------------------------------------*/
+static void journalEvents(GameState *journal) {
+    if (eventQueueTop == gameState.eventQueueTop
+        && (eventQueueTop == 0
+            || memcmp(eventQueue, gameState.eventQueue, eventQueueTop*sizeof(EventQueueEntry)) == 0))
+        return;
+
+    journal->eventsChanged = true;
+    journal->eventQueue = gameState.eventQueue;
+    journal->eventQueueTop = gameState.eventQueueTop;
+    journal->size += gameState.eventQueueTop*sizeof(EventQueueEntry);
+    collectEvents();
+}
+
+
+/*----------------------------------------------------------------------*/
+static WordChange *changeBuffer = NULL;
+static int changeBufferSize = 0;
+
+static void recordChange(GameState *journal, int offset, Aword value) {
+    if (journal->changeCount == changeBufferSize) {
+        changeBufferSize = changeBufferSize == 0 ? 256 : 2*changeBufferSize;
+        changeBuffer = realloc(changeBuffer, changeBufferSize*sizeof(WordChange));
+        if (changeBuffer == NULL)
+            syserr("Out of memory in 'recordChange()'");
+    }
+    changeBuffer[journal->changeCount].offset = offset;
+    changeBuffer[journal->changeCount].value = value;
+    journal->changeCount++;
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Record the words that differ from the checkpoint, and update it,
+   skipping quickly over unchanged pages */
+static void journalWords(GameState *journal, Aword *current, Aword *checkpoint,
+                         int words, int offset) {
+    int page, i;
+
+    for (page = 0; page < words; page += PAGE_SIZE) {
+        int length = words - page < PAGE_SIZE ? words - page : PAGE_SIZE;
+        if (memcmp(&current[page], &checkpoint[page], length*sizeof(Aword)) != 0)
+            for (i = page; i < page+length; i++)
+                if (current[i] != checkpoint[i]) {
+                    recordChange(journal, offset+i, checkpoint[i]);
+                    checkpoint[i] = current[i];
+                }
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void journalSets(GameState *journal) {
+    SetInitEntry *entry;
+    int count = countSets();
+    int i;
+
+    if (count == 0) return;
+
+    entry = pointerTo(header->setInitTable);
+    for (i = 0; i < count; i++) {
+        /* Compared in place, only a changed set is copied */
+        Set *set = fromAptr(getInstanceAttribute(entry[i].instanceCode, entry[i].attributeCode));
+        if (!equalSets(set, gameState.sets[i])) {
+            if (journal->sets == NULL)
+                journal->sets = allocate(count*sizeof(Set *));
+            journal->sets[i] = gameState.sets[i];
+            journal->size += sizeof(Set) + gameState.sets[i]->allocated*sizeof(Aword);
+            gameState.sets[i] = copySet(set);
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static void journalStrings(GameState *journal) {
+    StringInitEntry *entry;
+    int count = countStrings();
+    int i;
+
+    if (count == 0) return;
+
+    entry = pointerTo(header->stringInitTable);
+    for (i = 0; i < count; i++) {
+        /* Compared in place, only a changed string is copied */
+        char *string = fromAptr(getInstanceAttribute(entry[i].instanceCode, entry[i].attributeCode));
+        if (strcmp(string, gameState.strings[i]) != 0) {
+            if (journal->strings == NULL)
+                journal->strings = allocate(count*sizeof(char *));
+            journal->strings[i] = gameState.strings[i];
+            journal->size += strlen(gameState.strings[i])+1;
+            gameState.strings[i] = strdup(string);
+        }
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+/* Only the pages of the attribute area that were written can differ */
+static void journalAttributes(GameState *journal) {
+    int page;
+
+    for (page = nextWrittenAttributePage(0); page >= 0; page = nextWrittenAttributePage(page+1)) {
+        int start = page*ATTRIBUTE_PAGE_WORDS;
+        int words = header->attributesAreaSize - start;
+        if (words <= 0)
+            break;
+        if (words > ATTRIBUTE_PAGE_WORDS)
+            words = ATTRIBUTE_PAGE_WORDS;
+        journalWords(journal, &((Aword *)attributes)[start], &((Aword *)gameState.attributes)[start],
+                     words, adminWords()+start);
+    }
+    forgetWrittenAttributes();
+}
+
+
+/*----------------------------------------------------------------------*/
+static void journalInstanceData(GameState *journal) {
+    AdminField field;
+
+    journal->changeCount = 0;
+    for (field = 0; field < ADMIN_FIELDS; field++)
+        journalWords(journal, adminField(field), checkpointAdminField(field),
+                     header->instanceMax+1, field*(header->instanceMax+1));
+    journalAttributes(journal);
+    if (journal->changeCount > 0)
+        journal->changes = duplicate(changeBuffer, journal->changeCount*sizeof(WordChange));
+    journal->size += journal->changeCount*sizeof(WordChange);
+
+    journalSets(journal);
+    journalStrings(journal);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void journalScores(GameState *journal) {
+    journal->score = gameState.score;
+    gameState.score = current.score;
+    if (scores != NULL && gameState.scores != NULL
+        && memcmp(scores, gameState.scores, header->scoreCount*sizeof(Aword)) != 0) {
+        journal->scores = gameState.scores;
+        journal->size += header->scoreCount*sizeof(Aword);
+        gameState.scores = duplicate(scores, header->scoreCount*sizeof(Aword));
+    }
+}
+
+
+/*----------------------------------------------------------------------*/
+static bool tooMuchUndo(void) {
+    int depth = stateStackDepth(stateStack);
+
+    /* We need the top state and the one before to undo one level */
+    if (undoLevelsOption >= 0 && depth > undoLevelsOption+1)
+        return true;
+    return depth > 2 && journalSize > UNDO_MEMORY_BUDGET;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void limitUndoJournal(void) {
+    GameState oldest;
+    char *command;
+
+    while (stateStackDepth(stateStack) > 1 && tooMuchUndo()) {
+        removeOldestGameState(stateStack, &oldest, &command);
+        journalSize -= oldest.size;
+        deallocateGameState(&oldest);
+        if (command != NULL)
+            deallocate(command);
+    }
+}
+
+
 /*======================================================================*/
 void rememberGameState(void) {
-    collectEvents();
-    collectInstanceData();
-    collectScores();
+    GameState journal;
 
     if (stateStack == NULL)
         initStateStack();
 
-    pushGameState(stateStack, &gameState);
+    memset(&journal, 0, sizeof(journal));
+    journal.size = sizeof(GameState);
+    exportEventQueue();
+    if (stateStackIsEmpty(stateStack)) {
+        /* Nothing to compare with, so take a complete copy */
+        collectEvents();
+        collectInstanceData();
+        collectScores();
+    } else {
+        journalEvents(&journal);
+        journalInstanceData(&journal);
+        journalScores(&journal);
+    }
+
+    pushGameState(stateStack, &journal);
+    journalSize += journal.size;
+    limitUndoJournal();
     gameStateChanged = false;
 }
 
@@ -241,7 +583,7 @@ static void freeCurrentSetAttributes(void) {
 
     if (header->setInitTable == 0) return;
     for (entry = pointerTo(header->setInitTable); *(Aword *)entry != EOF; entry++) {
-        Aptr attributeValue = getAttribute(admin[entry->instanceCode].attributes, entry->attributeCode);
+        Aptr attributeValue = getAttribute(admin.attributes[entry->instanceCode], entry->attributeCode);
         freeSet((Set*)fromAptr(attributeValue));
     }
 }
@@ -256,10 +598,9 @@ static void recallSets(Set **sets) {
     if (header->setInitTable == 0) return;
 
     entry = pointerTo(header->setInitTable);
-    for (i = 0; i < count; i++) {
-        setAttribute(admin[entry[i].instanceCode].attributes, entry[i].attributeCode, toAptr(sets[i]));
-        sets[i] = NULL; /* Since we reuse the saved set, we need to clear the pointer */
-    }
+    for (i = 0; i < count; i++)
+        /* The checkpoint keeps its own copy */
+        setAttribute(admin.attributes[entry[i].instanceCode], entry[i].attributeCode, toAptr(copySet(sets[i])));
 }
 
 
@@ -269,7 +610,7 @@ static void freeCurrentStringAttributes(void) {
 
     if (header->stringInitTable == 0) return;
     for (entry = pointerTo(header->stringInitTable); *(Aword *)entry != EOF; entry++) {
-        Aptr attributeValue = getAttribute(admin[entry->instanceCode].attributes, entry->attributeCode);
+        Aptr attributeValue = getAttribute(admin.attributes[entry->instanceCode], entry->attributeCode);
         deallocate(fromAptr(attributeValue));
     }
 }
@@ -284,31 +625,38 @@ static void recallStrings(char **strings) {
     if (header->stringInitTable == 0) return;
 
     entry = pointerTo(header->stringInitTable);
-    for (i = 0; i < count; i++) {
-        setAttribute(admin[entry[i].instanceCode].attributes, entry[i].attributeCode, toAptr(strings[i]));
-        strings[i] = NULL;      /* Since we reuse the saved, we need to clear the state */
-    }
+    for (i = 0; i < count; i++)
+        /* The checkpoint keeps its own copy */
+        setAttribute(admin.attributes[entry[i].instanceCode], entry[i].attributeCode, toAptr(strdup(strings[i])));
 }
 
 
 /*----------------------------------------------------------------------*/
 static void recallEvents(void) {
     eventQueueTop = gameState.eventQueueTop;
+    if (eventQueueTop > eventQueueSize) {
+        deallocate(eventQueue);
+        eventQueue = allocate(eventQueueTop*sizeof(EventQueueEntry));
+        eventQueueSize = eventQueueTop;
+    }
     if (eventQueueTop > 0) {
         memcpy(eventQueue, gameState.eventQueue,
-               (eventQueueTop+1)*sizeof(EventQueueEntry));
+               eventQueueTop*sizeof(EventQueueEntry));
     }
+    importEventQueue();
 }
 
 
 /*----------------------------------------------------------------------*/
 static void recallInstances(void) {
+    AdminField field;
 
-    if (admin == NULL)
+    if (admin.location == NULL)
         syserr("admin[] == NULL in recallInstances()");
 
-    memcpy(admin, gameState.admin,
-           (header->instanceMax+1)*sizeof(AdminEntry));
+    for (field = 0; field < ADMIN_FIELDS; field++)
+        memcpy(adminField(field), checkpointAdminField(field), (header->instanceMax+1)*sizeof(Aword));
+    indexContainment();
 
     freeCurrentSetAttributes();		/* Need to free previous set values */
     freeCurrentStringAttributes();	/* Need to free previous string values */
@@ -318,23 +666,30 @@ static void recallInstances(void) {
 
     recallSets(gameState.sets);
     recallStrings(gameState.strings);
+    allAttributesChanged();
 }
 
 
 /*----------------------------------------------------------------------*/
 static void recallScores(void) {
     current.score = gameState.score;
-    memcpy(scores, gameState.scores, header->scoreCount*sizeof(Aword));
+    if (gameState.scores != NULL)
+        memcpy(scores, gameState.scores, header->scoreCount*sizeof(Aword));
 }
 
 
 /*======================================================================*/
 void recallGameState(void) {
-    popGameState(stateStack, &gameState, &playerCommand);
+    if (stateStackIsEmpty(stateStack))
+        syserr("Recalling GameState from empty stack");
+
+    /* The checkpoint is the state to recall... */
     recallEvents();
     recallInstances();
     recallScores();
-    deallocateGameState(&gameState);
+
+    /* ... and then it needs to go back one state */
+    popJournalEntry(&playerCommand);
 }
 
 
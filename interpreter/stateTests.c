@@ -10,7 +10,6 @@
 #define ATTRIBUTECOUNT 5
 
 static void setupInstances(void) {
-  int adminSize = (INSTANCEMAX+1)*sizeof(AdminEntry)/sizeof(Aword);
   int attributeAreaSize = (INSTANCEMAX+1)*ATTRIBUTECOUNT*sizeof(AttributeEntry)/sizeof(Aword);
   int i;
 
@@ -18,17 +17,26 @@ static void setupInstances(void) {
   header->attributesAreaSize = attributeAreaSize;
   header->instanceMax = INSTANCEMAX;
 
-  admin = allocate((INSTANCEMAX+1)*sizeof(AdminEntry));
-  for (i = 0; i < adminSize; i++) ((Aword *)admin)[i] = i;
+  allocateAdmin();
+  for (i = 0; i <= INSTANCEMAX; i++) {
+    admin.location[i] = i;
+    admin.visitsCount[i] = 10*i;
+    admin.step[i] = 100*i;
+  }
 
   attributes = allocate((INSTANCEMAX+1)*ATTRIBUTECOUNT*sizeof(AttributeEntry));
   for (i = 0; i < attributeAreaSize; i++) ((Aword *)attributes)[i] = i;
 
 }
 
+/* Written directly, so it must be noted like setInstanceAttribute() does */
+static void writeAttribute(int index, Aptr value) {
+  attributes[index].value = value;
+  attributeWordWritten((Aword *)&attributes[index].value - (Aword *)attributes);
+}
+
 static void teardownInstances() {
 	free(header);
-	free(admin);
 	free(attributes);
 }
 
@@ -36,6 +44,7 @@ static void teardownInstances() {
 Describe(State);
 BeforeEach(State) {
     setupInstances();
+    initStateStack();
 }
 AfterEach(State) {
     teardownInstances();
@@ -43,22 +52,26 @@ AfterEach(State) {
 
 
 Ensure(State, pushGameStateCollectsAdminAndAttributesData) {
-  int adminSize = (INSTANCEMAX+1)*sizeof(AdminEntry)/sizeof(Aword);
   int attributeAreaSize = ATTRIBUTECOUNT*INSTANCEMAX*sizeof(AttributeEntry)/sizeof(Aword);
+  int i;
 
   eventQueueTop = 0;
 
   rememberGameState();
 
   assert_true(memcmp(gameState.attributes, attributes, attributeAreaSize*sizeof(Aword)) == 0);
-  assert_true(memcmp(gameState.admin, admin, adminSize*sizeof(Aword)) == 0);
+  for (i = 0; i <= INSTANCEMAX; i++) {
+    assert_equal(checkpointAdminField(LOCATION_FIELD)[i], i);
+    assert_equal(checkpointAdminField(VISITS_COUNT_FIELD)[i], 10*i);
+    assert_equal(checkpointAdminField(STEP_FIELD)[i], 100*i);
+  }
 }
 
 Ensure(State, pushAndPopCanHandleSetAttributes) {
   Set *originalSet = newSet(3);
   SetInitEntry *initEntry;
 
-  admin[1].attributes = attributes;
+  admin.attributes[1] = attributes;
   attributes[0].code = 1;
   attributes[0].value = toAptr(originalSet);
   addToSet(originalSet, 7);
@@ -95,18 +108,18 @@ Ensure(State, pushAndPopCanHandleSetAttributes) {
 
 Ensure(State, canPushAndPopAttributeState) {
 
-  attributes[0].value = 12;
-  attributes[2].value = 3;
+  writeAttribute(0, 12);
+  writeAttribute(2, 3);
 
   rememberGameState();
 
-  attributes[0].value = 11;
-  attributes[2].value = 4;
+  writeAttribute(0, 11);
+  writeAttribute(2, 4);
 
   rememberGameState();
 
-  attributes[0].value = 55;
-  attributes[2].value = 55;
+  writeAttribute(0, 55);
+  writeAttribute(2, 55);
 
   recallGameState();
 
@@ -120,46 +133,84 @@ Ensure(State, canPushAndPopAttributeState) {
 }
 
 
+Ensure(State, journalsOnlyTheChangedWords) {
+  rememberGameState();
+
+  writeAttribute(2, 99);
+  admin.location[3] = 99;
+
+  rememberGameState();
+
+  assert_equal(journalSize, 2*sizeof(GameState) + 2*sizeof(WordChange));
+
+  recallGameState();
+  recallGameState();
+}
+
+
+Ensure(State, retainsOnlyTheConfiguredUndoLevels) {
+  int level;
+
+  undoLevelsOption = 2;
+  for (level = 1; level <= 5; level++) {
+    writeAttribute(0, level);
+    rememberGameState();
+  }
+  undoLevelsOption = -1;
+
+  assert_equal(stateStackDepth(stateStack), 3);
+
+  writeAttribute(0, 55);
+  recallGameState();
+  assert_equal(5, attributes[0].value);
+  recallGameState();
+  assert_equal(4, attributes[0].value);
+  recallGameState();
+  assert_equal(3, attributes[0].value);
+  assert_false(anySavedState());
+}
+
+
 Ensure(State, canPushAndPopAdminState) {
   int INSTANCE1_LOCATION = 12;
   int INSTANCE2_LOCATION = 22;
   int INSTANCE2_FIRST_SCRIPT = 3;
 
-  admin[1].location = INSTANCE1_LOCATION;
-  admin[2].script = INSTANCE2_FIRST_SCRIPT;
+  admin.location[1] = INSTANCE1_LOCATION;
+  admin.script[2] = INSTANCE2_FIRST_SCRIPT;
 
   rememberGameState();
 
-  admin[2].location = INSTANCE2_LOCATION;
+  admin.location[2] = INSTANCE2_LOCATION;
 
-  admin[2].alreadyDescribed = 2;
-  admin[2].visitsCount = 13;
-  admin[2].script = 33;
-  admin[2].step = 3886;
-  admin[2].waitCount = 38869878;
+  admin.alreadyDescribed[2] = 2;
+  admin.visitsCount[2] = 13;
+  admin.script[2] = 33;
+  admin.step[2] = 3886;
+  admin.waitCount[2] = 38869878;
 
   rememberGameState();
 
-  admin[2].location = 55;
-  admin[2].alreadyDescribed = 55;
-  admin[2].visitsCount = 55;
-  admin[2].script = 55;
-  admin[2].step = 55;
-  admin[2].waitCount = 55;
+  admin.location[2] = 55;
+  admin.alreadyDescribed[2] = 55;
+  admin.visitsCount[2] = 55;
+  admin.script[2] = 55;
+  admin.step[2] = 55;
+  admin.waitCount[2] = 55;
 
   recallGameState();
 
-  assert_equal(INSTANCE2_LOCATION, admin[2].location);
-  assert_equal(2, admin[2].alreadyDescribed);
-  assert_equal(13, admin[2].visitsCount);
-  assert_equal(33, admin[2].script);
-  assert_equal(3886, admin[2].step);
-  assert_equal(38869878, admin[2].waitCount);
+  assert_equal(INSTANCE2_LOCATION, admin.location[2]);
+  assert_equal(2, admin.alreadyDescribed[2]);
+  assert_equal(13, admin.visitsCount[2]);
+  assert_equal(33, admin.script[2]);
+  assert_equal(3886, admin.step[2]);
+  assert_equal(38869878, admin.waitCount[2]);
 
   recallGameState();
 
-  assert_equal(INSTANCE1_LOCATION, admin[1].location);
-  assert_equal(INSTANCE2_FIRST_SCRIPT, admin[2].script);
+  assert_equal(INSTANCE1_LOCATION, admin.location[1]);
+  assert_equal(INSTANCE2_FIRST_SCRIPT, admin.script[2]);
 }
 
 
@@ -116,7 +116,7 @@ void statusline(void)
     char line[100];
     int pcol = col;
 
-    if (!statusLineOption) return;
+    if (!statusLineOption || outputSuppressed) return;
     if (glkStatusWin == NULL)
         return;
 
@@ -155,7 +155,7 @@ void statusline(void)
     int i;
     int pcol = col;
 
-    if (!statusLineOption) return;
+    if (!statusLineOption || outputSuppressed) return;
     /* ansi_position(1,1); ansi_bold_on(); */
     printf("\x1b[1;1H");
     printf("\x1b[7m");
@@ -0,0 +1,158 @@
+/*----------------------------------------------------------------------*\
+
+  textcache
+
+  Cache of decoded strings. The entries are hashed on their position
+  and length and also kept in a list in order of use, the most
+  recently used first, so that the oldest can be dropped first.
+
+  Strings returned by findCachedText() are owned by the cache. They are
+  only dropped by trimTextCache() and clearTextCache(), so they stay
+  valid until one of those is called.
+
+\*----------------------------------------------------------------------*/
+#include "textcache.h"
+
+/* IMPORTS */
+#include <string.h>
+
+#include "options.h"
+#include "memory.h"
+
+
+/* PUBLIC DATA */
+int textCacheHits = 0;
+int textCacheMisses = 0;
+
+
+/* PRIVATE TYPES */
+typedef struct TextCacheEntry {
+    Aword fpos;
+    Aword len;
+    char *text;
+    long size;
+    struct TextCacheEntry *nextInBucket;
+    struct TextCacheEntry *newer;
+    struct TextCacheEntry *older;
+} TextCacheEntry;
+
+
+/* PRIVATE DATA */
+#define BUCKETS 1024
+
+static TextCacheEntry *bucket[BUCKETS];
+static TextCacheEntry *newest = NULL;
+static TextCacheEntry *oldest = NULL;
+static int entryCount = 0;
+static long totalSize = 0;
+
+
+/*----------------------------------------------------------------------*/
+static int hashOf(Aword fpos, Aword len) {
+    return (fpos ^ (len*31)) & (BUCKETS-1);
+}
+
+
+/*----------------------------------------------------------------------*/
+static void unlinkFromList(TextCacheEntry *entry) {
+    if (entry->newer != NULL)
+        entry->newer->older = entry->older;
+    else
+        newest = entry->older;
+    if (entry->older != NULL)
+        entry->older->newer = entry->newer;
+    else
+        oldest = entry->newer;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void linkAsNewest(TextCacheEntry *entry) {
+    entry->newer = NULL;
+    entry->older = newest;
+    if (newest != NULL)
+        newest->newer = entry;
+    newest = entry;
+    if (oldest == NULL)
+        oldest = entry;
+}
+
+
+/*----------------------------------------------------------------------*/
+static void dropEntry(TextCacheEntry *entry) {
+    TextCacheEntry **link = &bucket[hashOf(entry->fpos, entry->len)];
+
+    while (*link != entry)
+        link = &(*link)->nextInBucket;
+    *link = entry->nextInBucket;
+    unlinkFromList(entry);
+
+    totalSize -= entry->size;
+    entryCount--;
+    deallocate(entry->text);
+    deallocate(entry);
+}
+
+
+/*======================================================================*/
+char *findCachedText(Aword fpos, Aword len) {
+    TextCacheEntry *entry;
+
+    for (entry = bucket[hashOf(fpos, len)]; entry != NULL; entry = entry->nextInBucket)
+        if (entry->fpos == fpos && entry->len == len) {
+            textCacheHits++;
+            unlinkFromList(entry);
+            linkAsNewest(entry);
+            return entry->text;
+        }
+    textCacheMisses++;
+    return NULL;
+}
+
+
+/*======================================================================*/
+/* Add an allocated string, which is then owned by the cache */
+void cacheText(Aword fpos, Aword len, char *text) {
+    TextCacheEntry *entry = allocate(sizeof(TextCacheEntry));
+    int hash = hashOf(fpos, len);
+
+    entry->fpos = fpos;
+    entry->len = len;
+    entry->text = text;
+    entry->size = sizeof(TextCacheEntry) + strlen(text) + 1;
+    entry->nextInBucket = bucket[hash];
+    bucket[hash] = entry;
+    linkAsNewest(entry);
+
+    totalSize += entry->size;
+    entryCount++;
+}
+
+
+/*======================================================================*/
+/* Drop the least recently used strings until within the budget */
+void trimTextCache(void) {
+    long budget = (long)textCacheOption*1024;
+
+    while (oldest != NULL && totalSize > budget)
+        dropEntry(oldest);
+}
+
+
+/*======================================================================*/
+void clearTextCache(void) {
+    while (oldest != NULL)
+        dropEntry(oldest);
+}
+
+
+/*======================================================================*/
+int cachedTextCount(void) {
+    return entryCount;
+}
+
+
+/*======================================================================*/
+long cachedTextSize(void) {
+    return totalSize;
+}
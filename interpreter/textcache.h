@@ -0,0 +1,37 @@
+#ifndef TEXTCACHE_H_
+#define TEXTCACHE_H_
+/*----------------------------------------------------------------------*\
+
+  textcache
+
+  Cache of strings already decoded from the text data, identified by
+  their position and length, so that texts printed over and over again
+  need not be decoded every time. The least recently used strings are
+  dropped when the cache grows beyond its budget (textCacheOption).
+
+\*----------------------------------------------------------------------*/
+
+/* IMPORTS */
+#include "types.h"
+
+
+/* CONSTANTS */
+
+
+/* TYPES */
+
+
+/* DATA */
+extern int textCacheHits;
+extern int textCacheMisses;
+
+
+/* FUNCTIONS */
+extern char *findCachedText(Aword fpos, Aword len);
+extern void cacheText(Aword fpos, Aword len, char *text);
+extern void trimTextCache(void);
+extern void clearTextCache(void);
+extern int cachedTextCount(void);
+extern long cachedTextSize(void);
+
+#endif /* TEXTCACHE_H_ */
@@ -0,0 +1,84 @@
+#include <cgreen/cgreen.h>
+
+#include "textcache.h"
+
+#include "memory.h"
+#include "options.h"
+
+/* Mocked modules */
+#include "syserr.mock"
+#include "instance.mock"
+
+
+static char *copyOf(char *string) {
+    char *copy = allocate(strlen(string)+1);
+    strcpy(copy, string);
+    return copy;
+}
+
+
+Describe(TextCache);
+BeforeEach(TextCache) {
+    textCacheOption = 256;
+    textCacheHits = 0;
+    textCacheMisses = 0;
+}
+AfterEach(TextCache) {
+    clearTextCache();
+}
+
+
+Ensure(TextCache, finds_text_on_same_position_and_length) {
+    cacheText(10, 5, copyOf("hello"));
+    cacheText(10, 3, copyOf("hel"));
+
+    assert_that(findCachedText(10, 5), is_equal_to_string("hello"));
+    assert_that(findCachedText(10, 3), is_equal_to_string("hel"));
+    assert_that(findCachedText(11, 5), is_null);
+    assert_that(textCacheHits, is_equal_to(2));
+    assert_that(textCacheMisses, is_equal_to(1));
+}
+
+Ensure(TextCache, drops_least_recently_used_text_when_trimmed) {
+    char *text;
+
+    textCacheOption = 1;
+    text = allocate(600);
+    memset(text, 'a', 599);
+    cacheText(1, 599, text);
+    text = allocate(600);
+    memset(text, 'b', 599);
+    cacheText(2, 599, text);
+
+    findCachedText(1, 599);
+    trimTextCache();
+
+    assert_that(cachedTextCount(), is_equal_to(1));
+    assert_that(findCachedText(1, 599), is_non_null);
+    assert_that(findCachedText(2, 599), is_null);
+}
+
+Ensure(TextCache, keeps_texts_over_budget_until_trimmed) {
+    textCacheOption = 0;
+    cacheText(1, 5, copyOf("outer"));
+    cacheText(2, 5, copyOf("inner"));
+
+    assert_that(findCachedText(1, 5), is_equal_to_string("outer"));
+
+    trimTextCache();
+    assert_that(cachedTextCount(), is_equal_to(0));
+    assert_that(cachedTextSize(), is_equal_to(0));
+}
+
+Ensure(TextCache, handles_texts_in_the_same_bucket) {
+    cacheText(1024, 0, copyOf(""));
+    cacheText(0, 0, copyOf("x"));
+    cacheText(2048, 0, copyOf("y"));
+
+    clearTextCache();
+    cacheText(0, 0, copyOf("z"));
+
+    assert_that(findCachedText(0, 0), is_equal_to_string("z"));
+    assert_that(findCachedText(1024, 0), is_null);
+    assert_that(cachedTextCount(), is_equal_to(1));
+}
@@ -9,6 +9,8 @@
 #include "exe.h"
 #include "state.h"
 #include "lists.h"
+#include "profile.h"
+#include "image.h"
 
 #include "fnmatch.h"
 
@@ -28,7 +30,10 @@ void terminate(int code)
 
     stopTranscript();
 
-    if (memory)
+    if (profileOption)
+        writeProfile();
+
+    if (memory && !unloadImage())
         deallocate(memory);
 
 #ifdef HAVE_GLK
@@ -91,6 +96,15 @@ void usage(char *programName)
     printf("    -t[<n>]   trace game execution, higher <n> gives more trace\n");
     printf("    -r        make regression testing easier (don't timestamp, page break, randomize...)\n");
     printf("    -e        ignore version and checksum errors (dangerous)\n");
+    printf("    -undo<n>  only keep the last <n> moves for undo\n");
+    printf("    -cache<n> keep at most <n> kilobytes of decoded text (default 256)\n");
+    printf("    -profile  count executed instructions and write a profile ('.a3p')\n");
+    printf("    -image    keep a native image of the game ('.a3n') for faster start\n");
+    printf("    -checkrules also evaluate unchanged rules and check that they agree\n");
+    printf("    -batch[<n>] <manifest>\n");
+    printf("              replay the sessions listed in <manifest>, <n> at a time (default one per processor)\n");
+    printf("    -replay <log>\n");
+    printf("              restore a session by first replaying a command log ('.a3s') without output\n");
     printf("    --version print version and exit\n");
 #ifdef HAVE_GLK
     glk_set_style(style_Normal);
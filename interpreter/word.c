@@ -52,7 +52,7 @@ void ensureSpaceForPlayerWords(int size) {
 char *playerWordsAsCommandString(void) {
     char *commandString;
     int size = playerWords[lastWord].end - playerWords[firstWord].start;
-    commandString = allocate(size + 1);
+    commandString = allocateTemporary(size + 1);
     strncpy(commandString, playerWords[firstWord].start, size);
     commandString[size] = '\0';
     return commandString;
@@ -0,0 +1,5 @@
+rm -f replaySaveAndQuit.sav
+../../bin/alan replaySaveAndQuit
+../../bin/arun -r -replay replaySaveAndQuit.log replaySaveAndQuit < replaySaveAndQuit.input
+ls replaySaveAndQuit.sav
+rm replaySaveAndQuit.sav